@@ -2,44 +2,104 @@
 #define BUFFER_H
 
 #include <stdint.h>
-#include <deque>
-#include <iterator>
+#include <vector>
+#include <atomic>
 
 #include "flit.h"
 
-typedef enum { EMPTY, NOT_FULL, FULL } BUFFER_CAPACITY_STATUS;
+class Node;
+typedef struct _IO_Channel IO_Channel;
+
 typedef enum { UNRESERVED, RESERVED } BUFFER_RESERVED_STATUS;
 
+// everything a checkpoint keeps of a buffer besides its slots, the route is looked up again on restore
+typedef struct _Buffer_State {
+	uint32_t reserved_status;
+	uint32_t reserved_message_id;
+	uint32_t reserved_packet_id;
+	uint32_t head;
+	uint32_t tail;
+	uint32_t size;
+	uint32_t settled_size;
+	uint32_t num_blocked_cycles;
+	uint64_t occupancy_sum;
+	uint32_t is_routed;
+	uint32_t route_next_router_id;
+} Buffer_State;
+
+/* 
+ * Fixed capacity ring of flit handles. The slots are carved out of the owner's slab and
+ * rounded up to a power of two so head and tail are free running counters. During rx the
+ * owner inserts while a downstream node removes, so head is only written by the consumer,
+ * tail only by the producer, and the size is the one counter they share.
+ */
 class Buffer {
 
 private:
-	BUFFER_CAPACITY_STATUS capacity_status;
 	BUFFER_RESERVED_STATUS reserved_status;
 	uint32_t reserved_message_id;
 	uint32_t reserved_packet_id;
-	typedef typename std::deque<Flit*>::iterator iterator;
+	Flit_Handle* slots;
+	uint32_t slot_mask;
+	uint32_t head;
+	uint32_t tail;
+	std::atomic<uint32_t> size;
 
 public:
-	std::deque<Flit*>* queue;
+	class iterator {
+	private:
+		Buffer* buffer;
+		uint32_t position;
+	public:
+		iterator(Buffer* buffer, uint32_t position) : buffer(buffer), position(position) {}
+		Flit_Handle operator*() const { return buffer->slots[position & buffer->slot_mask]; }
+		iterator& operator++() { position++; return *this; }
+		iterator operator++(int) { iterator prev = *this; position++; return prev; }
+		bool operator!=(const iterator& other) const { return position != other.position; }
+	};
+
 	uint32_t max_capacity;
-	Buffer(uint32_t max_capacity);
-	void update_capacity_status();
+	uint32_t settled_size; // occupancy at the end of the previous cycle
+	Node* owner;
+
+	/* heatmap counters, plain increments since only the owner writes them */
+	uint64_t occupancy_sum; // settled occupancy summed over cycles
+	uint32_t num_blocked_cycles; // cycles the flit at the front could not be proposed
+
+	/* route register, set when the HEAD at the front is routed and cleared when the TAIL leaves */
+	bool is_routed;
+	uint32_t route_next_router_id;
+	std::vector<IO_Channel*>* route_io_channel_vec;
+
+	Buffer(uint32_t max_capacity, Node* owner);
+	static uint32_t get_num_slots(uint32_t max_capacity);
 	void reserve_buffer(uint32_t message_id, uint32_t packet_id);
 	void unreserve_buffer();
-	bool insert_flit(Flit* flit);
-	Flit* remove_flit();
-	Flit* peek_flit();
+	bool insert_flit(Flit_Handle flit);
+	Flit_Handle remove_flit();
+	Flit_Handle peek_flit();
 	uint32_t occupied_size();
 	uint32_t total_size();
 	bool is_full();
 	bool is_not_full();
 	bool is_empty();
+	void settle();
+	bool can_accept_flit();
+	bool can_accept_packet();
 	bool is_reserved_for_flit(uint32_t message_id, uint32_t packet_id);
 	bool is_unreserved();
+	uint32_t get_reserved_message_id();
+	uint32_t get_reserved_packet_id();
+	void set_route(uint32_t next_router_id, std::vector<IO_Channel*>* io_channel_vec);
+	void clear_route();
+	uint32_t get_num_slots();
+	void save_state(Buffer_State* state, Flit_Handle* slots);
+	void restore_state(Buffer_State* state, Flit_Handle* slots);
+	void reset();
 
 
-	iterator begin() { return queue->begin(); }
-	iterator end() { return queue->end(); }
+	iterator begin() { return iterator(this, this->head); }
+	iterator end() { return iterator(this, this->tail); }
 
 };
 
@@ -24,6 +24,13 @@ typedef struct _Transmission_State {
 } Transmission_State;
 
 
+class Channel;
+
+// order channels by id so iteration order does not depend on heap addresses
+struct channel_comp {
+	bool operator()(const Channel* channel_1, const Channel* channel_2) const;
+};
+
 class Channel {
 
 private:
@@ -35,19 +42,29 @@ private:
 public:
 	uint32_t channel_id;
 	Transmission_State* transmission_state; 
+
+	/* heatmap counters, plain increments since only the dest node writes them during its rx */
+	uint32_t num_flits_carried;
+	uint32_t num_busy_cycles; // cycles a flit was waiting on the channel, carried or not
+	uint32_t num_blocked_cycles; // cycles the dest node could not take the flit
 	
 	Channel (Node* source, Node* dest);
+	Channel (Node* source, Node* dest, uint32_t channel_id);
 	void init_buffer_lst (Buffer** buffer_lst, uint32_t num_buffers);
+	Node* get_dest();
 	void unlock();
 	void lock();
-	bool is_locked_for_flit(Flit* flit);
+	bool is_locked_for_flit(Flit_Handle flit);
 	bool is_unlocked();
-	bool is_dest_buffer_reserved_for_flit(Flit* flit);
-	bool is_dest_buffer_reserved_for_flit_and_full(Flit* flit);
-	bool is_dest_buffer_unreserved();
+	bool can_lock_for_flit(Flit_Handle flit);
+	bool is_dest_buffer_reserved_for_flit(Flit_Handle flit);
+	bool is_dest_buffer_reserved_for_flit_and_full(Flit_Handle flit);
+	bool is_dest_buffer_unreserved(Flit_Handle flit);
+	void get_virtual_channel_range(Flit_Handle flit, uint32_t* vc_begin, uint32_t* vc_end);
 	bool is_open_for_transmission();
 	bool is_closed_for_transmission();
 	void reset_transmission_state();
+	void reset();
 	void propose_transmission(Buffer* tx_buffer);
 	FLIT_TYPE execute_transmission(Buffer* rx_buffer);
 	FLIT_TYPE get_transmitted_flit_type();
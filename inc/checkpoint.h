@@ -0,0 +1,137 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "random_stream.h"
+
+class Network;
+class Trace_Reader;
+class Channel;
+class Buffer;
+
+#define CHECKPOINT_MAGIC 0x504b434e // "NCKP" in a little endian file
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_ALIGNMENT 64
+#define NO_CHECKPOINT_BUFFER ((uint32_t)-1)
+
+typedef enum {
+	CHECKPOINT_MESSAGE_INFO,
+	CHECKPOINT_PACKET_CHUNKS,
+	CHECKPOINT_PROCESSORS,
+	CHECKPOINT_QUEUED_MESSAGES,
+	CHECKPOINT_MESSAGE_IDS,
+	CHECKPOINT_ROUTERS,
+	CHECKPOINT_CHANNELS,
+	CHECKPOINT_BUFFERS,
+	CHECKPOINT_BUFFER_SLOTS,
+	NUM_CHECKPOINT_SECTIONS
+} CHECKPOINT_SECTION;
+
+// the simulator's sampling, heatmap and deadlock check bookkeeping, so a restored run picks up mid interval
+typedef struct _Checkpoint_Simulator_State {
+	uint32_t num_cycles_since_sample;
+	uint32_t last_tx_flits;
+	uint32_t last_rx_flits;
+	uint32_t last_num_stalls;
+	uint32_t last_buffers_space_occupied;
+	uint32_t last_buffers_space_total;
+	uint32_t next_heatmap_cycle;
+	uint32_t last_heatmap_cycle;
+	uint32_t num_cycles_since_check;
+	uint32_t reserved;
+	uint64_t num_flit_moves_at_check;
+} Checkpoint_Simulator_State;
+
+/*
+ * checkpoint_<cycle>.bin layout, native endian since a checkpoint is only read back by the same
+ * build: a Checkpoint_Header, then its sections at the recorded offsets, each aligned to
+ * CHECKPOINT_ALIGNMENT. Message infos and packet chunks are stored as the simulator keeps them
+ * in memory, with a chunk's owner replaced by the owning processor's id. A restore maps the file,
+ * points the packet chunks straight into it and copies the message infos of the created messages
+ * into the simulator's own lazily mapped array. Processors, routers, channels and buffers are
+ * stored in the order the Checkpoint walks the network, queued messages and message ids are
+ * concatenated in processor order, and a channel's tx buffer is an index into the buffers.
+ */
+typedef struct _Checkpoint_Header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t global_clock;
+	uint32_t num_messages;
+	uint32_t num_processors;
+	uint32_t num_routers;
+	uint32_t num_channels;
+	uint32_t num_buffers;
+	uint32_t num_buffer_slots;
+	uint32_t num_packet_chunks;
+	uint32_t num_queued_messages;
+	uint32_t num_message_ids;
+	uint32_t num_batches;
+	uint32_t trace_next_record;
+	Checkpoint_Simulator_State simulator_state;
+	uint64_t section_offset[NUM_CHECKPOINT_SECTIONS];
+} Checkpoint_Header;
+
+typedef struct _Processor_Checkpoint {
+	uint32_t free_lst;
+	uint32_t released_lst;
+	uint32_t num_flits_transmitted;
+	uint32_t num_flits_received;
+	uint32_t num_buffered_flits;
+	uint32_t num_occupied_buffers;
+	uint32_t num_queued_messages;
+	uint32_t num_transmitted_messages;
+	uint32_t num_received_messages;
+} Processor_Checkpoint;
+
+typedef struct _Router_Checkpoint {
+	uint32_t num_buffered_flits;
+	uint32_t num_occupied_buffers;
+	uint32_t num_stalls;
+	uint32_t total_num_stalls;
+	Random_Stream_State random_stream_state;
+} Router_Checkpoint;
+
+typedef struct _Channel_Checkpoint {
+	uint32_t tx_buffer_id;
+	uint32_t flit_status;
+	uint32_t lock_status;
+	uint32_t transmission_status;
+	uint32_t flit_type;
+	uint32_t packet_id;
+	uint32_t message_id;
+	uint32_t num_flits_carried;
+	uint32_t num_busy_cycles;
+	uint32_t num_blocked_cycles;
+} Channel_Checkpoint;
+
+/*
+ * Saves and restores everything that changes while the simulation runs. The network itself is
+ * rebuilt from the config as usual, so a checkpoint only restores into a run of the same config,
+ * and the continuation is only exact with deterministic random streams.
+ */
+class Checkpoint {
+
+private:
+	Network* network;
+	Trace_Reader* trace_reader;
+	uint32_t num_messages;
+	std::vector<Buffer*>* buffer_vec;
+	std::vector<Channel*>* channel_vec;
+	std::map<Buffer*, uint32_t>* buffer_id_map;
+	uint32_t num_buffer_slots;
+
+	void add_buffer(Buffer* buffer);
+
+public:
+	Checkpoint(Network* network, Trace_Reader* trace_reader, uint32_t num_messages);
+	~Checkpoint();
+	void save(std::string checkpoint_file_path, Checkpoint_Simulator_State* simulator_state);
+	void restore(std::string checkpoint_file_path, Checkpoint_Simulator_State* simulator_state);
+
+};
+
+#endif /* CHECKPOINT_H */
@@ -0,0 +1,52 @@
+#ifndef COMPLETION_TRACKER_H
+#define COMPLETION_TRACKER_H
+
+#include <stdint.h>
+#include <atomic>
+
+#include "worker_pool.h"
+#include "message.h"
+
+// messages created inside the measurement window are tagged, only they are counted in the results
+typedef enum { UNTAGGED_BATCH, TAGGED_BATCH, NUM_MEASUREMENT_BATCHES } MEASUREMENT_BATCH;
+
+typedef struct alignas(CACHE_LINE_SIZE) _Batch_Counter {
+	std::atomic<uint32_t> num_outstanding;
+} Batch_Counter;
+
+/*
+ * Outstanding message counts, in total and per batch. Messages are added in bulk during setup and
+ * counted down by the processor that receives their last flit, so checking whether the
+ * simulation or a batch is done never has to look at individual messages. Messages that have
+ * been injected but not delivered yet are counted too, which tells whether anything is in flight.
+ * A message starts out untagged and moves to the tagged batch once its creation cycle is known
+ * to fall inside the measurement window, which by default never ends.
+ */
+class Completion_Tracker {
+
+private:
+	uint32_t num_batches;
+	Batch_Counter* batch_counter_lst;
+	Batch_Counter total_counter;
+	Batch_Counter in_flight_counter;
+	uint32_t measurement_begin;
+	uint32_t measurement_end;
+
+public:
+	Completion_Tracker(uint32_t num_batches);
+	~Completion_Tracker();
+	uint32_t get_num_batches();
+	void add_messages(uint32_t batch_id, uint32_t num_messages);
+	void set_measurement_window(uint32_t measurement_begin, uint32_t measurement_end);
+	void record_created(Message_Transmission_Info* message_transmission_info);
+	void record_injected();
+	void record_delivered(uint32_t batch_id);
+	uint32_t get_num_outstanding();
+	uint32_t get_num_outstanding(uint32_t batch_id);
+	uint32_t get_num_in_flight();
+	bool is_all_delivered();
+	bool is_batch_delivered(uint32_t batch_id);
+
+};
+
+#endif /* COMPLETION_TRACKER_H */
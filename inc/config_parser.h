@@ -12,9 +12,12 @@ private:
 
 public:
 	Config_Parser();
+	~Config_Parser();
 	void initialize_parameter_key(string parameter_key);
+	void initialize_parameter_key(string parameter_key, string default_parameter_value);
 	string get_string_parameter_value(string parameter_key);
 	uint32_t get_int_parameter_value(string parameter_key);
+	double get_float_parameter_value(string parameter_key);
 	void parse_config_file(string config_file_path);
 	void print();
 };
@@ -0,0 +1,55 @@
+#ifndef DEADLOCK_DETECTOR_H
+#define DEADLOCK_DETECTOR_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include <map>
+
+#include "network.h"
+#include "node.h"
+#include "channel.h"
+#include "buffer.h"
+
+// one virtual channel of a router input port
+typedef struct _Wait_For_Node {
+	Router* router;
+	Channel* input_channel;
+	uint32_t vc;
+	Buffer* buffer;
+	bool can_progress;
+	std::vector<uint32_t>* wait_for_vec; // nodes that have to move before this one can
+} Wait_For_Node;
+
+/*
+ * Finds flits that can never move again. Every router virtual channel is a node of a wait-for
+ * graph with edges to the virtual channels it needs space or a released reservation from,
+ * and a node can progress if it has space, ejects into a processor, or waits on any node
+ * that can progress. Non empty virtual channels that can not progress are deadlocked, and
+ * following their edges leads to a cycle. Building the graph walks every buffer, so the
+ * simulator only does it once no flit has moved for a whole check interval.
+ */
+class Deadlock_Detector {
+
+private:
+	Network* network;
+	std::vector<Wait_For_Node>* node_vec;
+	std::map<Buffer*, uint32_t>* buffer_to_node_map;
+	std::map<uint64_t, std::vector<uint32_t>>* packet_to_node_map; // nodes holding flits of each packet
+	std::vector<uint32_t>* deadlocked_node_vec;
+
+	void build_wait_for_graph();
+	void add_wait_for_edges(uint32_t node_id);
+	void propagate_progress();
+	bool find_cycle(std::vector<uint32_t>* cycle_vec);
+
+public:
+	Deadlock_Detector(Network* network);
+	~Deadlock_Detector();
+	uint64_t count_flit_moves();
+	uint32_t detect();
+	void report(FILE* file);
+
+};
+
+#endif /* DEADLOCK_DETECTOR_H */
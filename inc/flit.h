@@ -5,52 +5,84 @@
 
 typedef enum { HEAD, DATA, TAIL } FLIT_TYPE;
 
-class Flit {
-
-public:
-	uint32_t flit_id;
-	uint32_t packet_id;
-	uint32_t message_id;
-	uint32_t num_packets;
-	FLIT_TYPE type;
-
-public:
-	Flit(uint32_t flit_id, uint32_t packet_id, uint32_t message_id, uint32_t num_packets, FLIT_TYPE type);
-
-};
-
-class Border_Flit : public Flit {
-
-public:
-	uint32_t source;
-	uint32_t dest;
-
-public:
-	Border_Flit(uint32_t flit_id, uint32_t packet_id, uint32_t message_id, uint32_t num_packets, FLIT_TYPE type, uint32_t source, uint32_t dest);
-
-};
-
-class Head_Flit : public Border_Flit {
-
-public:
-	uint32_t distance;
-	Head_Flit(uint32_t flit_id, uint32_t packet_id, uint32_t message_id, uint32_t num_packets, uint32_t source, uint32_t dest);
-	void increment_distance();
-
-};
-
-class Tail_Flit : public Border_Flit {
-
-public:
-	Tail_Flit(uint32_t flit_id, uint32_t packet_id, uint32_t message_id, uint32_t num_packets, uint32_t source, uint32_t dest);
-
-};
-
-class Data_Flit : public Flit {
-
-public:
-	Data_Flit(uint32_t flit_id, uint32_t packet_id, uint32_t message_id, uint32_t num_packets);
-
-};
-
-#endif /* FLIT_H */
\ No newline at end of file
+/* 
+ * A flit is a 32 bit handle, (packet slot << flit index bits) | flit index within the packet.
+ * Per packet fields are kept once per packet in struct of arrays chunks, and the flit type
+ * follows from the flit index, so buffers only ever move handles around.
+ */
+typedef uint32_t Flit_Handle;
+
+#define PACKET_CHUNK_BITS 8
+#define PACKET_CHUNK_SIZE (1 << PACKET_CHUNK_BITS)
+#define NO_PACKET_SLOT ((uint32_t)-1)
+
+class Flit_Pool;
+
+typedef struct _Packet_Chunk {
+	Flit_Pool* owner;
+	uint32_t message_id[PACKET_CHUNK_SIZE];
+	uint32_t packet_id[PACKET_CHUNK_SIZE];
+	uint32_t num_packets[PACKET_CHUNK_SIZE];
+	uint32_t dest[PACKET_CHUNK_SIZE];
+	uint32_t distance[PACKET_CHUNK_SIZE]; // hop count of the head flit
+	uint32_t next_free[PACKET_CHUNK_SIZE];
+} Packet_Chunk;
+
+extern Packet_Chunk** global_packet_chunk_lst;
+extern uint32_t flit_index_bits;
+extern uint32_t tail_flit_index;
+
+void init_flit_table(uint32_t num_data_flits_per_packet);
+
+inline Flit_Handle make_flit_handle(uint32_t packet_slot, uint32_t flit_index) {
+	return (packet_slot << flit_index_bits) | flit_index;
+}
+
+inline uint32_t get_flit_packet_slot(Flit_Handle flit) {
+	return flit >> flit_index_bits;
+}
+
+inline uint32_t get_flit_index(Flit_Handle flit) {
+	return flit & ((1 << flit_index_bits) - 1);
+}
+
+inline Packet_Chunk* get_flit_packet_chunk(Flit_Handle flit) {
+	return global_packet_chunk_lst[get_flit_packet_slot(flit) >> PACKET_CHUNK_BITS];
+}
+
+inline uint32_t get_flit_chunk_offset(Flit_Handle flit) {
+	return get_flit_packet_slot(flit) & (PACKET_CHUNK_SIZE - 1);
+}
+
+inline FLIT_TYPE get_flit_type(Flit_Handle flit) {
+	uint32_t flit_index = get_flit_index(flit);
+	if (flit_index == 0) return HEAD;
+	if (flit_index == tail_flit_index) return TAIL;
+	return DATA;
+}
+
+inline uint32_t get_flit_message_id(Flit_Handle flit) {
+	return get_flit_packet_chunk(flit)->message_id[get_flit_chunk_offset(flit)];
+}
+
+inline uint32_t get_flit_packet_id(Flit_Handle flit) {
+	return get_flit_packet_chunk(flit)->packet_id[get_flit_chunk_offset(flit)];
+}
+
+inline uint32_t get_flit_num_packets(Flit_Handle flit) {
+	return get_flit_packet_chunk(flit)->num_packets[get_flit_chunk_offset(flit)];
+}
+
+inline uint32_t get_flit_dest(Flit_Handle flit) {
+	return get_flit_packet_chunk(flit)->dest[get_flit_chunk_offset(flit)];
+}
+
+inline uint32_t get_flit_distance(Flit_Handle flit) {
+	return get_flit_packet_chunk(flit)->distance[get_flit_chunk_offset(flit)];
+}
+
+inline void increment_flit_distance(Flit_Handle flit) {
+	get_flit_packet_chunk(flit)->distance[get_flit_chunk_offset(flit)] += 1;
+}
+
+#endif /* FLIT_H */
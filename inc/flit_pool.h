@@ -0,0 +1,35 @@
+#ifndef FLIT_POOL_H
+#define FLIT_POOL_H
+
+#include <stdint.h>
+#include <atomic>
+
+#include "flit.h"
+
+/* 
+ * Packet slots for the flits of one processor. Only the owning processor allocates,
+ * but packets are released by whichever processor ejects their tail flit, so released
+ * slots go on an atomic list that the owner takes over once its own free list runs out.
+ */
+class Flit_Pool {
+
+private:
+	uint32_t free_lst;
+	std::atomic<uint32_t> released_lst;
+
+	void grow();
+
+public:
+	Flit_Pool();
+	uint32_t new_packet(uint32_t message_id, uint32_t packet_id, uint32_t num_packets, uint32_t dest);
+	static void release_packet(uint32_t packet_slot);
+	void save_state(uint32_t* free_lst, uint32_t* released_lst);
+	void restore_state(uint32_t free_lst, uint32_t released_lst);
+	static uint32_t get_num_packet_chunks();
+	static void restore_packet_chunks(Packet_Chunk** packet_chunk_lst, uint32_t num_restored_chunks);
+	void reset();
+	static void reset_packet_chunks();
+
+};
+
+#endif /* FLIT_POOL_H */
@@ -0,0 +1,51 @@
+#ifndef HEATMAP_WRITER_H
+#define HEATMAP_WRITER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+class Channel;
+class Buffer;
+
+#define HEATMAP_MAGIC 0x504d484e // "NHMP" in a little endian file
+#define HEATMAP_VERSION 1
+
+/*
+ * heatmap.bin layout, all fields little endian: a Heatmap_Header, then num_snapshots snapshots.
+ * A snapshot is its cycle and a reserved word followed by one port record per router, row
+ * major, and per port of the router in the network's port order. A port record is the input
+ * channel's flits carried, busy cycles, blocked cycles and whether the port is connected,
+ * then per virtual channel the buffer's occupancy sum as two words, low first, its blocked
+ * cycles and a reserved word. Counters are totals since the start of the simulation.
+ */
+typedef struct _Heatmap_Header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t num_rows;
+	uint32_t num_cols;
+	uint32_t num_ports;
+	uint32_t num_virtual_channels;
+	uint32_t num_snapshots;
+	uint32_t reserved;
+} Heatmap_Header;
+
+class Heatmap_Writer {
+
+private:
+	FILE* heatmap_file;
+	Heatmap_Header header;
+	std::vector<uint32_t>* snapshot_vec;
+
+public:
+	Heatmap_Writer(std::string heatmap_file_path, uint32_t num_rows, uint32_t num_cols, uint32_t num_ports, uint32_t num_virtual_channels);
+	~Heatmap_Writer();
+	void begin_snapshot(uint32_t cycle);
+	void append_port(Channel* channel, Buffer** buffers, uint32_t num_buffers);
+	void end_snapshot();
+	void close();
+
+};
+
+#endif /* HEATMAP_WRITER_H */
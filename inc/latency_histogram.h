@@ -0,0 +1,70 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <vector>
+
+// latencies below 2^LATENCY_SUB_BUCKET_BITS get a bucket each, above that every power of two
+// is split into 2^(LATENCY_SUB_BUCKET_BITS-1) buckets, so a bucket is within ~3% of its values
+#define LATENCY_SUB_BUCKET_BITS 6
+#define NUM_DISTANCE_CLASSES 8 // 0, 1, 2-3, 4-7, ..., 64 and up hops
+
+typedef enum { GLOBAL_LATENCY_CLASS, DISTANCE_LATENCY_CLASS, REGION_LATENCY_CLASS } LATENCY_CLASS_KIND;
+
+/*
+ * Log linear latency histogram in the style of HDR histograms. Buckets are only allocated up to
+ * the largest latency recorded, and two histograms are merged by adding up their buckets.
+ */
+class Latency_Histogram {
+
+private:
+	std::vector<uint32_t>* count_vec;
+	uint32_t total_count;
+	uint32_t max_latency;
+
+public:
+	Latency_Histogram();
+	~Latency_Histogram();
+	void record(uint32_t latency);
+	void merge(Latency_Histogram* histogram);
+	uint32_t get_total_count();
+	uint32_t get_max_latency();
+	uint32_t get_percentile(double percentile);
+	uint32_t get_num_buckets();
+	uint32_t get_bucket_count(uint32_t bucket_index);
+	static uint32_t get_bucket_index(uint32_t latency);
+	static uint32_t get_bucket_low(uint32_t bucket_index);
+	static uint32_t get_bucket_high(uint32_t bucket_index);
+
+};
+
+/*
+ * A global histogram plus one per hop distance class and one per source/destination region pair.
+ * Regions are equal sized blocks of processor ids. Every processor records the messages it
+ * receives into its own set and the sets are merged once the simulation is done.
+ */
+class Latency_Histogram_Set {
+
+private:
+	uint32_t num_processors;
+	uint32_t num_regions;
+	uint32_t num_classes;
+	Latency_Histogram** histogram_lst; // allocated on first use
+
+	Latency_Histogram* get_or_create_histogram(uint32_t class_index);
+
+public:
+	Latency_Histogram_Set(uint32_t num_processors, uint32_t num_regions);
+	~Latency_Histogram_Set();
+	void record(uint32_t latency, uint32_t distance, uint32_t source, uint32_t dest);
+	void merge(Latency_Histogram_Set* histogram_set);
+	uint32_t get_num_classes();
+	Latency_Histogram* get_histogram(uint32_t class_index);
+	LATENCY_CLASS_KIND get_class_kind(uint32_t class_index);
+	void get_class_range(uint32_t class_index, uint32_t* class_low, uint32_t* class_high);
+	uint32_t get_region(uint32_t processor_id);
+	static uint32_t get_distance_class(uint32_t distance);
+
+};
+
+#endif /* LATENCY_HISTOGRAM_H */
@@ -3,7 +3,7 @@
 
 #include <stdint.h>
 
-#include "packet.h"
+#define NO_DEPENDENCY 0xFFFFFFFF
 
 typedef struct _Message_Transmission_Info {
 	uint32_t latency;
@@ -13,20 +13,26 @@ typedef struct _Message_Transmission_Info {
 	int tx_time;
 	uint32_t rx_processor_id;
 	int rx_time;
+	int creation_time; // -1 until known, closed loop messages are created when their source injects them
+	uint32_t batch_id;
+	uint32_t num_flits_remaining; // counted down by the dest processor as flits arrive
 } Message_Transmission_Info;
 
+// compact descriptor kept by value in the source processor's queue, flits only exist once it is injected
 class Message {
 
 public:
 	uint32_t message_id;
 	uint32_t size;
-	uint32_t num_packets;
-	uint32_t num_flits;
 	uint32_t source;
 	uint32_t dest;
-	Packet** packet_lst;
+	uint32_t release_time; // earliest clock cycle the source processor may inject the message
+	uint32_t dependency_id; // message that has to be received before this one is injected, or NO_DEPENDENCY
 	
-	Message(uint32_t size, uint32_t message_id, uint32_t source, uint32_t dest);
+	Message(uint32_t size, uint32_t message_id, uint32_t source, uint32_t dest, uint32_t release_time, uint32_t dependency_id);
+	bool is_ready();
+	uint32_t get_num_packets();
+	uint32_t get_num_flits();
 	
 
 };
@@ -3,12 +3,16 @@
 
 #include <map>
 #include <vector>
+#include <deque>
 #include <omp.h>
 
 #include "message.h"
+#include "random_stream.h"
+#include "traffic_patterns.h"
 
-typedef enum { NODE_UNIFORM, NODE_RANDOM } MESSAGE_NODE_DISTRIBUTION;
+typedef enum { NODE_UNIFORM, NODE_RANDOM, NODE_TRANSPOSE, NODE_BIT_COMPLEMENT, NODE_BIT_REVERSE, NODE_SHUFFLE, NODE_TORNADO, NODE_NEIGHBOR, NODE_HOTSPOT } MESSAGE_NODE_DISTRIBUTION;
 typedef enum { SIZE_UNIFORM, SIZE_RANDOM} MESSAGE_SIZE_DISTRIBUTION;
+typedef enum { INJECTION_BATCH, INJECTION_BERNOULLI, INJECTION_POISSON } MESSAGE_INJECTION_PROCESS;
 
 class Message_Generator {
 private:
@@ -17,13 +21,21 @@ private:
 	uint32_t upper_message_size;
 	MESSAGE_NODE_DISTRIBUTION message_node_distribution;
 	MESSAGE_SIZE_DISTRIBUTION message_size_distribution;
-	std::map<uint32_t, std::vector<Message*>*>* processor_id_to_tx_message_data_map;
-	std::map<uint32_t, std::map<uint32_t, int>*>* processor_id_to_rx_message_data_map;
+	MESSAGE_INJECTION_PROCESS message_injection_process;
+	double injection_rate; // messages per processor per clock cycle
+	double hotspot_fraction;
+	std::vector<uint32_t>* hotspot_vec;
+	std::map<uint32_t, std::deque<Message>*>* processor_id_to_tx_message_queue_map;
 	uint32_t* message_size_lst;
 	uint32_t* num_messages_tx_by_processor;
 	uint32_t* num_messages_rx_by_processor;
 	omp_lock_t* tx_message_data_map_locks;
 	omp_lock_t* rx_message_data_map_locks;
+	Random_Stream* size_random_stream;
+	Random_Stream* node_random_stream;
+	Random_Stream* shuffle_random_stream;
+	Random_Stream* injection_random_stream;
+	Random_Stream* pattern_random_stream;
 
 public:
 	uint32_t num_messages;
@@ -33,14 +45,20 @@ public:
 					  uint32_t lower_message_size, 
 					  uint32_t upper_message_size, 
 					  MESSAGE_SIZE_DISTRIBUTION message_size_distribution,
-					  MESSAGE_NODE_DISTRIBUTION message_node_distribution);
-	void update_tx_rx_data(Message* message);
+					  MESSAGE_NODE_DISTRIBUTION message_node_distribution,
+					  MESSAGE_INJECTION_PROCESS message_injection_process,
+					  double injection_rate,
+					  double hotspot_fraction,
+					  std::vector<uint32_t>* hotspot_vec);
+	~Message_Generator();
+	void update_tx_rx_data(Message message);
 	void random_message_size_distribution_generator();
 	void uniform_message_size_distribution_generator();
 	void random_message_node_distribution_generator();
 	void uniform_message_node_distribution_generator();
-	std::vector<Message*>* get_tx_message_data_vec(uint32_t processor_id);
-	std::map<uint32_t, int>* get_rx_message_data_map(uint32_t processor_id);
+	void pattern_message_node_distribution_generator(Traffic_Pattern_Func traffic_pattern_func);
+	void open_loop_message_release_generator();
+	std::deque<Message>* get_tx_message_queue(uint32_t processor_id);
 
 };
 
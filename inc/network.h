@@ -4,24 +4,68 @@
 #include <stdint.h>
 #include <vector>
 #include <map>
+#include <string>
 
 #include "flow_control_algorithms.h"
 #include "routing_algorithms.h"
 #include "node.h"
+#include "worker_pool.h"
+#include "heatmap_writer.h"
 
-typedef enum { MESH } NETWORK_TYPE;
+typedef enum { MESH, TORUS } NETWORK_TYPE;
+typedef enum { FULL_SWEEP, ACTIVE_SET, WORKER_POOL } SIMULATION_ENGINE;
 
+// router input ports in heatmap order, a port is named after the node it receives from
+typedef enum { NORTH_PORT, EAST_PORT, SOUTH_PORT, WEST_PORT, INJECTION_PORT, EJECTION_PORT, NUM_MESH_PORTS } MESH_PORT;
+
+// per thread partial sums, cache line aligned so threads never write to the same cache line. flit and
+// stall counts are totals since the start of the simulation, buffer space is what is in use right now
+typedef struct alignas(CACHE_LINE_SIZE) _Over_Time_Metrics {
+	uint32_t tx_flits;
+	uint32_t rx_flits;
+	uint32_t num_stalls;
+	uint32_t buffers_space_occupied;
+	uint32_t buffers_space_total;
+} Over_Time_Metrics;
+
+// a torus uses the same coordinates, its rows and columns are rings
 typedef struct _Mesh_Info {
 	uint32_t num_rows;
 	uint32_t num_cols;
 } Mesh_Info;
 
+class Active_Set {
+
+private:
+	uint32_t num_threads;
+	std::vector<Node*>** scheduled_node_vecs;
+
+public:
+	std::vector<Router*>* router_vec;
+	std::vector<Processor*>* processor_vec;
+
+	Active_Set(uint32_t num_threads);
+	void insert(Node* node);
+	void merge_scheduled_nodes();
+	void retire_idle_nodes();
+	void clear();
+};
+
 class Network {
 
 protected:
 	uint32_t input_buffer_capacity;
 	uint32_t router_buffer_capacity;
 	uint32_t num_virtual_channels;
+	SIMULATION_ENGINE engine;
+	Active_Set* active_set;
+	uint32_t num_partitions;
+	std::vector<Router*>** partition_router_vecs;
+	std::vector<Processor*>** partition_processor_vecs;
+
+	void simulate_full_sweep();
+	void simulate_active_set();
+	virtual void init_partitions(uint32_t num_partitions);
 
 public: 
 	uint32_t num_processors;
@@ -34,7 +78,15 @@ public:
 			uint32_t router_buffer_capacity, 
 			uint32_t num_virtual_channels);
 	void init_connection(Node* node_A, Node* node_B);
+	void init_simulation_engine(SIMULATION_ENGINE engine);
+	void reset();
 	void simulate();
+	void tx_partition(uint32_t partition_id);
+	void rx_partition(uint32_t partition_id);
+	void summarize_partition(uint32_t partition_id);
+	void sum_partition_metrics(uint32_t partition_id, Over_Time_Metrics* metrics);
+	virtual Heatmap_Writer* create_heatmap_writer(std::string heatmap_file_path) {return NULL;};
+	virtual void write_heatmap_snapshot(Heatmap_Writer* heatmap_writer) {};
 	virtual void print() {};
 
 };
@@ -46,11 +98,44 @@ typedef struct _Mesh_ID {
 
 class Mesh_Network: public Network {
 
-private:
+protected:
 	Processor*** processor_mesh;
 	Processor_Router*** router_mesh;
 	uint32_t num_rows;
 	uint32_t num_cols;
+	uint32_t num_channels;
+	Channel** channel_lst;
+	bool has_wraparound; // the edge routers of every row and column are linked to each other
+	Routing_Func routing_func;
+	Flow_Control_Func flow_control_func;
+	FLOW_CONTROL_GRANULARITY flow_control_granularity;
+
+	/* tile decomposition */
+	uint32_t num_tiles;
+	uint32_t num_tile_rows;
+	uint32_t num_tile_cols;
+	Sense_Barrier* build_barrier;
+
+	static void build_mesh_tile_thread(uint32_t thread_id, void* arg);
+	void init_tiles(uint32_t num_tiles);
+	void get_tile_bounds(uint32_t tile_id, uint32_t* row_begin, uint32_t* row_end, uint32_t* col_begin, uint32_t* col_end);
+	uint32_t get_processor_channel_id(uint32_t row, uint32_t col);
+	uint32_t get_router_channel_id(uint32_t row, uint32_t col, bool is_south);
+	bool get_neighbor(uint32_t row, uint32_t col, MESH_PORT port, uint32_t* neighbor_row, uint32_t* neighbor_col);
+	void build_tile(uint32_t tile_id);
+	Channel* get_port_channel(uint32_t row, uint32_t col, MESH_PORT port);
+	void init_partitions(uint32_t num_partitions);
+
+	Mesh_Network(NETWORK_TYPE topology,
+				 uint32_t num_processors, 
+				 uint32_t num_routers, 
+				 uint32_t input_buffer_capacity, 
+				 uint32_t router_buffer_capacity, 
+				 uint32_t num_virtual_channels,
+				 Routing_Func routing_func, 
+				 Flow_Control_Func tx_flow_control_func, 
+				 FLOW_CONTROL_GRANULARITY flow_control_granularity,
+				 Worker_Pool* worker_pool);
 
 public:
 	Mesh_Network(uint32_t num_processors, 
@@ -60,9 +145,33 @@ public:
 				 uint32_t num_virtual_channels,
 				 Routing_Func routing_func, 
 				 Flow_Control_Func tx_flow_control_func, 
-				 FLOW_CONTROL_GRANULARITY flow_control_granularity);
+				 FLOW_CONTROL_GRANULARITY flow_control_granularity,
+				 Worker_Pool* worker_pool);
+	Heatmap_Writer* create_heatmap_writer(std::string heatmap_file_path);
+	void write_heatmap_snapshot(Heatmap_Writer* heatmap_writer);
 	void print();
 
 };
 
+/*
+ * A mesh whose rows and columns wrap around, built the same way. Both dimensions need at least
+ * three routers so every ring has distinct east and west neighbors. The virtual channels of router
+ * to router links are split into dateline escape channels and adaptive ones by
+ * get_virtual_channel_range, which needs at least two virtual channels.
+ */
+class Torus_Network: public Mesh_Network {
+
+public:
+	Torus_Network(uint32_t num_processors, 
+				  uint32_t num_routers, 
+				  uint32_t input_buffer_capacity, 
+				  uint32_t router_buffer_capacity, 
+				  uint32_t num_virtual_channels,
+				  Routing_Func routing_func, 
+				  Flow_Control_Func tx_flow_control_func, 
+				  FLOW_CONTROL_GRANULARITY flow_control_granularity,
+				  Worker_Pool* worker_pool);
+
+};
+
 #endif /* NETWORK_H */
\ No newline at end of file
@@ -6,12 +6,16 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <deque>
 #include <omp.h>
 
 #include "flow_control_algorithms.h"
 #include "routing_algorithms.h"
 #include "channel.h"
 #include "message.h"
+#include "random_stream.h"
+#include "flit_pool.h"
+#include "latency_histogram.h"
 
 typedef enum { PROCESSOR, ROUTER, PROCESSOR_ROUTER } NODE_TYPE;
 
@@ -20,32 +24,17 @@ typedef struct _IO_Channel {
 	Channel* output_channel;
 } IO_Channel;
 
-class Flit_Info_To_Router_ID_Cache {
-
-private:
-	std::map<Flit_Info*, uint32_t, flit_info_comp>* flit_info_to_router_id_map;
-	omp_lock_t lock;
-
-public:
-	Flit_Info_To_Router_ID_Cache();
-	void insert(Flit_Info* flit_info, uint32_t next_dest_router_id);
-	void erase(Flit_Info* flit_info);
-	uint32_t find(Flit_Info* flit_info);
-	bool is_in(Flit_Info* flit_info);
-};
-
 class Internal_Info_Summary {
 
 public:
-	std::map<uint32_t, std::set<uint32_t>*>* message_id_to_packet_id_set_map;
-	std::map<Buffer*, std::set<Flit_Info*, flit_info_comp>*>* buffer_to_flit_info_set_map;
-	uint32_t buffer_space_occupied;
+	// occupancy lives in the owning node's counter, buffer contents are only walked by print
+	std::vector<Buffer*>* buffer_vec;
 	uint32_t buffer_space_total;
 	uint32_t num_stalls;
+	uint32_t total_num_stalls;
 
 	Internal_Info_Summary();
-	void init_buffer_in_map(Buffer* buffer);
-	void insert(Buffer* buffer, uint32_t message_id, uint32_t packet_id);
+	void init_buffer(Buffer* buffer);
 	void increment_num_stalls();
 	void clear();
 	void print();
@@ -65,10 +54,27 @@ public:
 	NODE_TYPE type;
 	Internal_Info_Summary* internal_info_summary;
 
+	/* active set bookkeeping */
+	bool is_scheduled;
+	uint32_t num_occupied_buffers;
+	uint32_t num_buffered_flits;
+
+	/* one contiguous slab backs the slots of all buffers of the node */
+	Flit_Handle* buffer_slot_slab;
+	uint32_t num_free_buffer_slots;
+
 	Node(uint32_t node_id, void* network_id, uint32_t num_channels, uint32_t num_neighbors, uint32_t max_buffer_capacity, NODE_TYPE type);
 	virtual void init_connection(Node* node, Channel* input_channel, Channel* output_channel) {};
 	virtual void tx() {};
 	virtual void rx() {};
+	virtual bool has_pending_work() { return false; };
+	virtual void reset();
+	void schedule();
+	void unschedule();
+	void notify_flit_inserted(bool was_empty);
+	void notify_flit_removed(bool is_empty);
+	void init_buffer_slot_slab(uint32_t num_buffers);
+	Flit_Handle* allocate_buffer_slots(uint32_t num_slots);
 
 };
 
@@ -82,10 +88,10 @@ public:
 	Routing_Func routing_func;
 	Flow_Control_Func flow_control_func;
 	FLOW_CONTROL_GRANULARITY flow_control_granularity;
-	std::map<Channel*, Buffer**>* input_channel_to_buffers_map;
+	std::map<Channel*, Buffer**, channel_comp>* input_channel_to_buffers_map;
 	std::map<Router*, std::vector<IO_Channel*>*>* neighbor_to_io_channels_map;
-	Flit_Info_To_Router_ID_Cache* flit_info_to_router_id_cache;
 	Internal_Info_Summary* internal_info_summary;
+	Random_Stream* random_stream;
 
 	Router(uint32_t node_id, 
 		   void* network_id,
@@ -99,11 +105,13 @@ public:
 	void init_connection(Node* node, Channel* input_channel, Channel* output_channel);
 	std::vector<IO_Channel*>* get_io_channel_vec(uint32_t neighbor_router_id);
 	void update_internal_info_summary();
-	void erase_cached_routing(uint32_t message_id, uint32_t packet_id);
 	uint32_t get_buffer_space_occupied();
 	uint32_t get_buffer_space_total();
 	uint32_t get_num_stalls();
+	uint32_t get_total_num_stalls();
 	void clear_internal_info_summary();
+	bool has_pending_work();
+	void reset();
 	void print();
 	void tx();
 	void rx();
@@ -118,14 +126,13 @@ private:
 	Channel* router_output_channel;
 	Buffer* injection_buffer;
 	Buffer* router_buffer;
-	bool transmit_message_flag;
-	bool receive_message_flag;
+	Flit_Pool* flit_pool;
 
 	void init_router_connection(Router* router, Channel* input_channel, Channel* output_channel);
 
 public:
-	std::vector<Message*>* tx_message_vec;
-	std::map<uint32_t, int>* rx_message_id_to_num_flits_map;
+	std::deque<Message>* tx_message_queue;
+	Latency_Histogram_Set* latency_histogram_set;
 	uint32_t num_flits_transmitted;
 	std::vector<uint32_t>* transmitted_messages_vec;
 	std::vector<uint32_t>* received_messages_vec;
@@ -136,14 +143,21 @@ public:
 			  uint32_t num_channels, 
 			  uint32_t num_neighbors, 
 			  uint32_t max_buffer_capacity);
-	void init_tx_message_vec(std::vector<Message*>* tx_message_vec);
-	void init_rx_message_map(std::map<uint32_t, int>* rx_message_id_to_num_flits_map);
+	void init_tx_message_queue(std::deque<Message>* tx_message_queue);
+	void init_latency_histogram_set(Latency_Histogram_Set* latency_histogram_set);
+	void enqueue_message(Message message);
 	void init_connection(Node* node, Channel* input_channel, Channel* output_channel);
 	void inject_message(Message* message);
+	bool has_pending_work();
+	uint32_t get_next_injection_time();
+	void record_flit_transmitted();
+	Buffer* get_injection_buffer();
+	Buffer* get_router_buffer();
+	Channel* get_router_input_channel();
+	Flit_Pool* get_flit_pool();
+	void reset();
 	void tx();
 	void rx();
-	bool did_transmit_message();
-	bool did_receive_message();
 	void print();
 
 	// void dummy_update();
@@ -0,0 +1,36 @@
+#ifndef OVER_TIME_RECORDER_H
+#define OVER_TIME_RECORDER_H
+
+#include <stdint.h>
+
+#include "stats_writer.h"
+
+/*
+ * Folds over time samples into windows of window_size samples. With a ring size of 0 every
+ * window is handed to the stats writer as soon as it is full, otherwise only the last
+ * ring_size windows are kept and they are written out on close, so memory stays bounded
+ * however long the simulation runs.
+ */
+class Over_Time_Recorder {
+
+private:
+	Stats_Writer* stats_writer;
+	uint32_t window_size;
+	uint32_t ring_size;
+	Over_Time_Window current_window;
+	Over_Time_Window* window_ring;
+	uint32_t ring_head;
+	uint32_t num_ring_windows;
+
+	void finish_window();
+
+public:
+	Over_Time_Recorder(Stats_Writer* stats_writer, uint32_t window_size, uint32_t ring_size);
+	~Over_Time_Recorder();
+	void add_sample(uint32_t num_cycles, uint32_t tx_flits, uint32_t rx_flits, uint32_t num_stalls, uint32_t buffers_space_occupied, uint32_t buffers_space_total);
+	void add_idle_cycles(uint32_t num_cycles, uint32_t buffers_space_total);
+	void close();
+
+};
+
+#endif /* OVER_TIME_RECORDER_H */
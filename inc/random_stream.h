@@ -0,0 +1,45 @@
+#ifndef RANDOM_STREAM_H
+#define RANDOM_STREAM_H
+
+#include <stdint.h>
+#include <vector>
+
+typedef enum { ROUTER_STREAM, PROCESSOR_STREAM, GENERATOR_STREAM } RANDOM_STREAM_DOMAIN;
+
+typedef struct _Random_Stream_State {
+	uint32_t key[2];
+	uint32_t counter[4];
+	uint32_t block[4];
+	uint32_t block_idx;
+} Random_Stream_State;
+
+/* 
+ * Counter based random numbers (Philox4x32-10). Every draw is a pure function of
+ * (seed, domain, stream id, epoch, draw index), so results do not depend on which
+ * thread runs a node or in what order. When deterministic mode is off, draws fall
+ * back to the shared libc rand() state.
+ */
+class Random_Stream {
+
+private:
+	uint32_t key[2];
+	uint32_t counter[4];
+	uint32_t block[4];
+	uint32_t block_idx;
+	void generate_block();
+
+public:
+	Random_Stream(RANDOM_STREAM_DOMAIN domain, uint32_t stream_id);
+	void seek(uint32_t epoch);
+	uint32_t next();
+	uint32_t next_below(uint32_t bound);
+	double next_unit();
+	void shuffle(std::vector<uint32_t>* vec);
+	void save_state(Random_Stream_State* state);
+	void restore_state(Random_Stream_State* state);
+
+};
+
+void init_random_streams(uint32_t seed, bool is_deterministic);
+
+#endif /* RANDOM_STREAM_H */
@@ -4,6 +4,15 @@
 #include "network.h"
 #include "message_generator.h"
 #include "config_parser.h"
+#include "worker_pool.h"
+#include "trace_reader.h"
+#include "stats_writer.h"
+#include "over_time_recorder.h"
+#include "latency_histogram.h"
+#include "heatmap_writer.h"
+#include "deadlock_detector.h"
+#include "checkpoint.h"
+#include "sweep_runner.h"
 
 class Simulator {
 
@@ -12,45 +21,91 @@ private:
 
 	std::string test_path;
 	std::string config_file_path;
-	std::string tx_stats_path;
-	std::string rx_stats_path;
-	std::string stalls_stats_path;
-	std::string buffers_stats_path;
-	std::string transmissions_stats_path;
-	std::string aggregate_stats_path;
+	std::string stats_path;
+	std::string heatmap_path;
 	
 	Network* network;
 	Message_Generator* message_generator;
+	Trace_Reader* trace_reader; // messages come from the trace instead of the generator when set
+	uint32_t num_messages;
 	Config_Parser* config_parser;
 	bool is_simulation_finished;
 	int num_threads;
+	SIMULATION_ENGINE engine;
+	Worker_Pool* worker_pool;
+	uint32_t first_cpu; // the pool pins its threads to the allowed cpus from here on
+	Over_Time_Metrics* thread_over_time_metrics;
+	std::string network_signature; // the parameters the network was built with, a reset reuses it only if they match
 
 	/* aggregate simulation metrics */
 	uint32_t total_message_latency;
+	uint32_t total_message_queueing_delay; // part of the latency spent waiting at the source
 	float total_message_distance; // same as avg packet distance
 	uint32_t total_message_size;
 	float avg_message_latency;
+	float avg_message_queueing_delay;
 	float avg_message_distance;
 	float avg_message_size;
 	float avg_message_throughput;
 	float avg_message_speed;
+	Latency_Histogram_Set* latency_histogram_set; // every processor's histograms merged
+	uint32_t num_latency_regions;
 
-	/* over time simulation metrics */
-	std::vector<uint32_t>* tx_flits_over_time_vec; // how many flits were transmitted by processors
-	std::vector<uint32_t>* rx_flits_over_time_vec; // how many flits were received by processors
-	std::vector<uint32_t>* stalls_over_time_vec; // metric for contention in network
-	std::vector<float>* buffers_efficiency_over_time_vec; // metric for how "busy" network is
+	/* over time simulation metrics, sampled every sample_interval cycles and streamed out in windows */
+	Stats_Writer* stats_writer;
+	Over_Time_Recorder* over_time_recorder;
+	uint32_t sample_interval;
+	uint32_t num_cycles_since_sample;
+	Over_Time_Metrics last_sample_metrics; // running totals at the previous sample
+	bool is_sample_due; // the worker pool threads sum their partitions this cycle
+	bool is_thread_metrics_fresh; // the worker pool threads summed their partitions in the last simulated cycle
+
+	/* per link and per virtual channel counters, snapshotted every heatmap_interval cycles and at the end */
+	Heatmap_Writer* heatmap_writer;
+	uint32_t heatmap_interval;
+	uint32_t next_heatmap_cycle;
+	uint32_t last_heatmap_cycle;
 
 	/* deadlock check */
-	int num_flits_in_network;
-	uint32_t sample_rate;
+	Deadlock_Detector* deadlock_detector;
+	uint64_t num_flit_moves_at_check;
+	uint32_t num_cycles_since_check;
+	uint32_t check_interval;
+	bool is_deadlocked;
+
+	/* checkpoints every checkpoint_interval cycles, first_cycle is where a restored run picked up */
+	Checkpoint* checkpoint;
+	uint32_t checkpoint_interval;
+	uint32_t next_checkpoint_cycle;
+	uint32_t first_cycle;
+
+	/* warm-up, measurement and drain phases, only messages created in [warmup_cycles, measurement_end) are measured */
+	uint32_t warmup_cycles;
+	uint32_t measurement_cycles; // 0 measures every message
+	uint32_t drain_cycles; // 0 waits for every tagged message after the measurement window
+	uint32_t measurement_end;
+	uint32_t num_measured_messages;
 
 public:
-	Simulator(std::string test_path, bool is_verbose);
+	Simulator(std::string test_path, bool is_verbose, SIMULATION_ENGINE engine, uint32_t first_cpu);
+	static bool is_network_parameter(std::string key);
+	void reset(std::string test_path);
 	void setup();
 	void update_over_time_metrics();
+	void sample_over_time_metrics();
+	void update_heatmap();
+	void record_over_time_metrics(Over_Time_Metrics* metrics);
 	void update_aggregate_metrics();
 	void update_simulation_status();
+	void check_deadlock();
+	bool has_deadlocked();
+	bool is_measured_message(Message_Transmission_Info* message_transmission_info);
+	void update_checkpoint();
+	void restore_checkpoint(std::string checkpoint_file_path);
+	void get_sweep_result(Sweep_Result* result);
+	void fast_forward_quiescent_cycles();
+	void release_trace_messages();
+	void simulate_worker_pool_cycles(uint32_t thread_id);
 	void simulate();
 	void log_stats();
 	void print_global_message_transmission_info();
@@ -0,0 +1,96 @@
+#ifndef STATS_WRITER_H
+#define STATS_WRITER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#define STATS_MAGIC 0x5354534e // "NSTS" in a little endian file
+#define STATS_VERSION 2
+#define STATS_CHUNK_ROWS 4096
+#define STATS_MAX_COLUMNS 16
+
+typedef enum { OVER_TIME_TABLE, MESSAGES_TABLE, AGGREGATE_TABLE, LATENCY_PERCENTILES_TABLE, LATENCY_HISTOGRAM_TABLE, NUM_STATS_TABLES } STATS_TABLE;
+
+/* 
+ * stats.bin layout, all fields little endian: a Stats_Header, schema_size bytes of schema text
+ * with one "table column:type ..." line per table in STATS_TABLE order, then chunks until the
+ * end of the file. A chunk is a table id and a row count followed by each column's values
+ * back to back, every value 4 bytes. Over time rows are windows of num_cycles cycles, see
+ * Over_Time_Window.
+ * src/stats_exporter.py turns the file back into the text stats files.
+ */
+typedef struct _Stats_Header {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t config_hash; // FNV-1a of config.txt
+	uint32_t first_cycle;
+	uint32_t last_cycle;
+	uint32_t schema_size;
+	uint32_t reserved;
+} Stats_Header;
+
+typedef struct _Window_Stat {
+	uint32_t sum;
+	uint32_t min;
+	uint32_t max;
+} Window_Stat;
+
+// one over time row, the counts of each sample are summed over its cycles and the window
+// keeps the sum, min and max over its samples, so the mean is sum / num_samples
+typedef struct _Over_Time_Window {
+	uint32_t num_cycles;
+	uint32_t num_samples; // 0 for a fast forwarded run of idle cycles
+	Window_Stat tx_flits;
+	Window_Stat rx_flits;
+	Window_Stat num_stalls;
+	Window_Stat buffers_space_occupied;
+	uint32_t buffers_space_total;
+} Over_Time_Window;
+
+typedef struct _Stats_Chunk {
+	uint32_t table_id;
+	uint32_t num_rows;
+	uint32_t* column_data; // STATS_CHUNK_ROWS values per column
+} Stats_Chunk;
+
+/*
+ * Rows are collected into per table chunks by the simulation thread, full chunks are handed
+ * to a background thread that writes them out, and written chunks are recycled.
+ */
+class Stats_Writer {
+
+private:
+	FILE* stats_file;
+	Stats_Header header;
+	std::thread* writer_thread;
+	std::mutex chunk_lock;
+	std::condition_variable chunk_cond;
+	std::deque<Stats_Chunk*>* full_chunk_queue;
+	std::vector<Stats_Chunk*>* free_chunk_vec;
+	Stats_Chunk* open_chunk_lst[NUM_STATS_TABLES];
+	bool is_closed;
+
+	Stats_Chunk* get_free_chunk(uint32_t table_id);
+	void submit_chunk(uint32_t table_id);
+	void append_row(uint32_t table_id, const uint32_t* row);
+	void write_chunks();
+
+public:
+	Stats_Writer(std::string stats_file_path, std::string config_file_path);
+	~Stats_Writer();
+	void append_over_time_row(Over_Time_Window* window);
+	void append_message_row(uint32_t latency, uint32_t size, uint32_t distance, uint32_t tx_processor_id, uint32_t tx_time, uint32_t rx_processor_id, uint32_t rx_time);
+	void append_aggregate_row(float latency, float distance, float size, float throughput, float speed);
+	void append_latency_percentiles_row(uint32_t class_kind, uint32_t class_low, uint32_t class_high, uint32_t count, uint32_t p50, uint32_t p90, uint32_t p99, uint32_t p999, uint32_t max);
+	void append_latency_histogram_row(uint32_t class_kind, uint32_t class_low, uint32_t class_high, uint32_t bucket_low, uint32_t bucket_high, uint32_t count);
+	void close(uint32_t first_cycle, uint32_t last_cycle);
+
+};
+
+#endif /* STATS_WRITER_H */
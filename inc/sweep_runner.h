@@ -0,0 +1,97 @@
+#ifndef SWEEP_RUNNER_H
+#define SWEEP_RUNNER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "network.h"
+
+#define SWEEP_MAGIC 0x5057534e // "NSWP" in a little endian file
+#define SWEEP_VERSION 1
+
+typedef enum { SWEEP_PENDING, SWEEP_FINISHED, SWEEP_DEADLOCKED, SWEEP_FAILED } SWEEP_RUN_STATUS;
+
+typedef std::vector<std::pair<std::string, std::string>> Sweep_Config;
+
+/*
+ * sweep_results.bin layout, all fields little endian: a Sweep_Header, num_runs Sweep_Results
+ * indexed by run id, then the string table. A run's config string is the "Key: value" lines
+ * of the options it was given, the same as test_contents.txt lists for a test suite, and the
+ * full config.txt, out.log and stats.bin of run i are in run_<i>/ next to the results file.
+ */
+typedef struct _Sweep_Header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t num_runs;
+	uint32_t reserved;
+	uint64_t string_table_offset;
+	uint64_t string_table_size;
+} Sweep_Header;
+
+typedef struct _Sweep_Result {
+	uint32_t run_id;
+	uint32_t status;
+	int32_t exit_code;
+	uint32_t config_offset; // into the string table
+	uint32_t config_size;
+	uint32_t num_cycles;
+	uint32_t num_measured_messages;
+	float avg_message_latency;
+	float avg_message_queueing_delay;
+	float avg_message_distance;
+	float avg_message_size;
+	float avg_message_throughput;
+	float avg_message_speed;
+	uint32_t p50_latency;
+	uint32_t p90_latency;
+	uint32_t p99_latency;
+	uint32_t p999_latency;
+	uint32_t max_latency;
+	double simulation_time;
+} Sweep_Result;
+
+/*
+ * Runs every config of a sweep spec, num_jobs at a time. The simulator keeps its state in
+ * process globals, so runs go to forked children with their own num_threads team, and children
+ * write their results straight into their slots of the results file. Runs that build the same
+ * network are batched, and a child builds the network once and resets it between its runs.
+ *
+ * A spec starts with base "Key: value" lines in config.txt form. A "Permute" line opens a group
+ * whose options are crossed with each other, a "Zip" line one whose options advance together,
+ * and the options of a group are "Key: value | value | ...". Groups are crossed with each other
+ * in order, the last one varying fastest, as in test_suite_generator.py.
+ */
+class Sweep_Runner {
+
+private:
+	std::string output_path;
+	uint32_t num_jobs;
+	uint32_t num_threads;
+	SIMULATION_ENGINE engine;
+	uint32_t seed;
+	bool is_deterministic;
+	Sweep_Config* base_config;
+	std::vector<Sweep_Config>* run_config_vec; // the options each run was given
+	std::vector<uint32_t>* config_offset_vec;
+	std::vector<std::vector<uint32_t>>* batch_vec; // run ids, a child runs one batch
+	int results_fd;
+
+	void parse_spec(std::string spec_file_path);
+	void write_results_header();
+	void write_result(Sweep_Result* result);
+	void read_result(uint32_t run_id, Sweep_Result* result);
+	Sweep_Config get_full_config(uint32_t run_id);
+	void plan_batches();
+	std::string get_run_path(uint32_t run_id);
+	void run_child(uint32_t batch_id, uint32_t slot);
+
+public:
+	Sweep_Runner(std::string spec_file_path, std::string output_path, uint32_t num_jobs, uint32_t num_threads, SIMULATION_ENGINE engine, uint32_t seed, bool is_deterministic);
+	uint32_t get_num_runs();
+	uint32_t run();
+
+};
+
+#endif /* SWEEP_RUNNER_H */
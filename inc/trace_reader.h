@@ -0,0 +1,66 @@
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <stdint.h>
+#include <string>
+
+#include "message.h"
+
+#define TRACE_MAGIC 0x4354524e // "NRTC" in a little endian file
+#define TRACE_VERSION 1
+
+/* 
+ * Binary trace layout, all fields little endian: one Trace_Header followed by num_records
+ * Trace_Records sorted by injection cycle. A record's message id is its index in the file,
+ * and its dependency, if any, is the id of an earlier record that has to be received before
+ * this one may be injected. src/trace_converter.py builds traces from a text form.
+ */
+typedef struct _Trace_Header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t num_records;
+	uint32_t num_processors;
+	uint32_t max_message_size;
+	uint32_t reserved;
+} Trace_Header;
+
+typedef struct _Trace_Record {
+	uint32_t injection_cycle;
+	uint32_t source;
+	uint32_t dest;
+	uint32_t size;
+	uint32_t dependency_id;
+} Trace_Record;
+
+/*
+ * Walks a memory mapped trace front to back. Pages behind the cursor are handed back to the
+ * kernel as it advances, so only a window of the trace is ever resident.
+ */
+class Trace_Reader {
+
+private:
+	int fd;
+	size_t file_size;
+	uint8_t* file_data;
+	Trace_Record* record_lst;
+	uint32_t next_record;
+	uint32_t next_released_record; // records before this one have had their pages dropped
+
+	void release_consumed_pages();
+
+public:
+	uint32_t num_records;
+	uint32_t num_processors;
+	uint32_t max_message_size;
+
+	Trace_Reader(std::string trace_file_path);
+	~Trace_Reader();
+	bool has_next();
+	uint32_t get_next_id();
+	uint32_t get_next_injection_cycle();
+	Trace_Record* next();
+	void seek(uint32_t record_id);
+
+};
+
+#endif /* TRACE_READER_H */
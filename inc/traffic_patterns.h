@@ -0,0 +1,35 @@
+#ifndef TRAFFIC_PATTERNS_H
+#define TRAFFIC_PATTERNS_H
+
+#include <stdint.h>
+
+/* 
+ * Processors sit on a num_cols x num_cols mesh with id = row*num_cols + col. Bit patterns work on
+ * the num_bits bits of a processor id and wrap results back into range when the number of
+ * processors is not a power of two. Random patterns read per message draws filled in by the caller.
+ */
+typedef struct _Traffic_Pattern_Info {
+	uint32_t num_processors;
+	uint32_t num_cols;
+	uint32_t num_bits;
+	uint32_t* draw_lst; // two random draws per message
+	uint32_t num_hotspots;
+	uint32_t* hotspot_lst;
+	uint32_t hotspot_threshold; // messages whose draw is below this go to a hotspot
+} Traffic_Pattern_Info;
+
+// plain arithmetic over the arrays with no calls or branches out of the loop, so the loops vectorize
+typedef void (*Traffic_Pattern_Func)(const uint32_t*, uint32_t*, uint32_t, Traffic_Pattern_Info*);
+
+/* Permutation Patterns */
+void transpose_traffic_pattern(const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info);
+void bit_complement_traffic_pattern(const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info);
+void bit_reverse_traffic_pattern(const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info);
+void shuffle_traffic_pattern(const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info);
+void tornado_traffic_pattern(const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info);
+void neighbor_traffic_pattern(const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info);
+
+/* Random Patterns */
+void hotspot_traffic_pattern(const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info);
+
+#endif /* TRAFFIC_PATTERNS_H */
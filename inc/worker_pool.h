@@ -0,0 +1,71 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <sched.h>
+
+// per thread data is declared alignas(CACHE_LINE_SIZE), which pads it out to whole cache lines
+#define CACHE_LINE_SIZE 64
+
+/* 
+ * Sense reversing barrier. The last thread to arrive can run serial work before
+ * releasing the others, so a reduction does not need a barrier of its own.
+ */
+typedef struct alignas(CACHE_LINE_SIZE) _Thread_Sense {
+	bool sense;
+} Thread_Sense;
+
+class Sense_Barrier {
+
+private:
+	uint32_t num_threads;
+	alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> num_arrived;
+	alignas(CACHE_LINE_SIZE) std::atomic<bool> sense;
+	Thread_Sense* thread_senses;
+
+public:
+	Sense_Barrier(uint32_t num_threads);
+	bool arrive(uint32_t thread_id);
+	void release(uint32_t thread_id);
+	void wait(uint32_t thread_id);
+
+};
+
+typedef void (*Worker_Func)(uint32_t thread_id, void* arg);
+
+/* 
+ * Threads are created and pinned once, then park between jobs. The calling thread
+ * runs as thread 0, so a job uses exactly num_threads cores.
+ */
+class Worker_Pool {
+
+private:
+	std::thread** threads;
+	std::mutex lock;
+	std::condition_variable job_ready;
+	std::condition_variable job_done;
+	Worker_Func job_func;
+	void* job_arg;
+	uint32_t job_id;
+	uint32_t num_running_threads;
+	bool is_shutdown;
+	bool is_pinned;
+	cpu_set_t caller_cpu_set;
+
+	void worker_loop(uint32_t thread_id);
+
+public:
+	uint32_t num_threads;
+	Sense_Barrier* barrier;
+
+	Worker_Pool(uint32_t num_threads, uint32_t first_cpu);
+	~Worker_Pool();
+	void run(Worker_Func func, void* arg);
+
+};
+
+#endif /* WORKER_POOL_H */
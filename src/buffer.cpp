@@ -1,30 +1,38 @@
 #include <stdint.h>
-#include <deque>
+#include <atomic>
 #include <cassert>
 #include <signal.h>
+#include <string.h>
 
 #include "buffer.h"
 #include "flit.h"
+#include "node.h"
 
-Buffer::Buffer (uint32_t max_capacity) {
-	this->queue = new std::deque<Flit*>;
+Buffer::Buffer (uint32_t max_capacity, Node* owner) {
+	uint32_t num_slots = Buffer::get_num_slots(max_capacity);
+	this->slots = owner->allocate_buffer_slots(num_slots);
+	this->slot_mask = num_slots - 1;
+	this->head = 0;
+	this->tail = 0;
+	this->size.store(0);
 	this->max_capacity = max_capacity;
-	this->capacity_status = EMPTY;
+	this->owner = owner;
+	this->settled_size = 0;
+	this->occupancy_sum = 0;
+	this->num_blocked_cycles = 0;
 	this->reserved_status = UNRESERVED;
 	this->reserved_message_id = (uint32_t)-1;
 	this->reserved_packet_id = (uint32_t)-1;
+	this->is_routed = false;
+	this->route_next_router_id = (uint32_t)-1;
+	this->route_io_channel_vec = NULL;
 }
 
-void Buffer::update_capacity_status () {
-	if (this->queue->empty()) {
-		this->capacity_status = EMPTY;
-	}
-	else if (this->queue->size() == this->max_capacity) {
-		this->capacity_status = FULL;
-	}
-	else {
-		this->capacity_status = NOT_FULL;
-	}
+// smallest power of two that holds max_capacity flits
+uint32_t Buffer::get_num_slots (uint32_t max_capacity) {
+	uint32_t num_slots = 1;
+	while (num_slots < max_capacity) num_slots <<= 1;
+	return num_slots;
 }
 
 void Buffer::reserve_buffer (uint32_t message_id, uint32_t packet_id) {
@@ -41,46 +49,60 @@ void Buffer::unreserve_buffer () {
 	this->reserved_packet_id = (uint32_t)-1;
 }
 
-bool Buffer::insert_flit (Flit* flit) {
-	bool is_successful = false;
-	if (this->capacity_status != FULL) {
-		is_successful = true;
-		this->queue->push_back(flit);
-	}
-	this->update_capacity_status();
-	return is_successful;
+bool Buffer::insert_flit (Flit_Handle flit) {
+	if (this->size.load(std::memory_order_relaxed) == this->max_capacity) return false;
+	this->slots[this->tail & this->slot_mask] = flit;
+	this->tail++;
+	// buffer went from empty to non empty, so owner has work to do next cycle
+	this->owner->notify_flit_inserted(this->size.fetch_add(1, std::memory_order_acq_rel) == 0);
+	return true;
 }
 
-Flit* Buffer::remove_flit () {
-	assert(!this->queue->empty());
-	Flit* flit = this->queue->front();
-	this->queue->pop_front();
-	this->update_capacity_status();
+Flit_Handle Buffer::remove_flit () {
+	assert(this->size.load(std::memory_order_relaxed) != 0);
+	Flit_Handle flit = this->slots[this->head & this->slot_mask];
+	this->head++;
+	this->owner->notify_flit_removed(this->size.fetch_sub(1, std::memory_order_acq_rel) == 1);
 	return flit;
 }
 
-Flit* Buffer::peek_flit () {
-	Flit* flit = this->queue->front();
-	return flit;
+Flit_Handle Buffer::peek_flit () {
+	return this->slots[this->head & this->slot_mask];
 }
 
 bool Buffer::is_full () {
-	this->update_capacity_status();
-	return this->capacity_status == FULL;
+	return this->size.load(std::memory_order_relaxed) == this->max_capacity;
 }
 
+// holds flits but still has room
 bool Buffer::is_not_full () {
-	this->update_capacity_status();
-	return this->capacity_status == NOT_FULL;
+	uint32_t size = this->size.load(std::memory_order_relaxed);
+	return (size - 1) < (this->max_capacity - 1);
 }
 
 bool Buffer::is_empty () {
-	this->update_capacity_status();
-	return this->capacity_status == EMPTY;
+	return this->size.load(std::memory_order_relaxed) == 0;
+}
+
+// called by the owner once all transmissions of a cycle are done
+void Buffer::settle () {
+	this->settled_size = this->size.load(std::memory_order_relaxed);
+	this->occupancy_sum += this->settled_size;
+}
+
+// the receiving router only looks at space freed up in earlier cycles, so the outcome
+// does not depend on whether the downstream router already pulled a flit this cycle
+bool Buffer::can_accept_flit () {
+	return this->settled_size < this->max_capacity;
+}
+
+// drained by the end of the previous cycle, for the same reason
+bool Buffer::can_accept_packet () {
+	return this->settled_size == 0;
 }
 
 uint32_t Buffer::occupied_size () {
-	return (uint32_t)this->queue->size();
+	return this->size.load(std::memory_order_relaxed);
 }
 
 uint32_t Buffer::total_size () {
@@ -93,7 +115,70 @@ bool Buffer::is_reserved_for_flit (uint32_t message_id, uint32_t packet_id) {
 	return is_reserved && is_matching;
 }
 
+uint32_t Buffer::get_reserved_message_id () {return this->reserved_message_id;}
+uint32_t Buffer::get_reserved_packet_id () {return this->reserved_packet_id;}
+
 bool Buffer::is_unreserved () {
 	bool is_unreserved = this->reserved_status == UNRESERVED;
 	return is_unreserved;
-}
\ No newline at end of file
+}
+
+// a buffer only routes the packet at its front, so one register per buffer is enough
+void Buffer::set_route (uint32_t next_router_id, std::vector<IO_Channel*>* io_channel_vec) {
+	this->is_routed = true;
+	this->route_next_router_id = next_router_id;
+	this->route_io_channel_vec = io_channel_vec;
+}
+
+void Buffer::clear_route () {
+	this->is_routed = false;
+	this->route_next_router_id = (uint32_t)-1;
+	this->route_io_channel_vec = NULL;
+}
+
+uint32_t Buffer::get_num_slots () {return this->slot_mask + 1;}
+
+// slots are copied whole so head and tail keep their positions
+void Buffer::save_state (Buffer_State* state, Flit_Handle* slots) {
+	state->reserved_status = (uint32_t)this->reserved_status;
+	state->reserved_message_id = this->reserved_message_id;
+	state->reserved_packet_id = this->reserved_packet_id;
+	state->head = this->head;
+	state->tail = this->tail;
+	state->size = this->size.load(std::memory_order_relaxed);
+	state->settled_size = this->settled_size;
+	state->num_blocked_cycles = this->num_blocked_cycles;
+	state->occupancy_sum = this->occupancy_sum;
+	state->is_routed = this->is_routed ? 1 : 0;
+	state->route_next_router_id = this->route_next_router_id;
+	memcpy(slots, this->slots, this->get_num_slots() * sizeof(Flit_Handle));
+}
+
+// the route register is left cleared, the caller sets it again from the owner's channels
+void Buffer::restore_state (Buffer_State* state, Flit_Handle* slots) {
+	this->reserved_status = (BUFFER_RESERVED_STATUS)state->reserved_status;
+	this->reserved_message_id = state->reserved_message_id;
+	this->reserved_packet_id = state->reserved_packet_id;
+	this->head = state->head;
+	this->tail = state->tail;
+	this->size.store(state->size, std::memory_order_relaxed);
+	this->settled_size = state->settled_size;
+	this->num_blocked_cycles = state->num_blocked_cycles;
+	this->occupancy_sum = state->occupancy_sum;
+	this->clear_route();
+	memcpy(this->slots, slots, this->get_num_slots() * sizeof(Flit_Handle));
+}
+
+// back to the state the constructor left it in, the slots stay allocated
+void Buffer::reset () {
+	this->head = 0;
+	this->tail = 0;
+	this->size.store(0, std::memory_order_relaxed);
+	this->settled_size = 0;
+	this->occupancy_sum = 0;
+	this->num_blocked_cycles = 0;
+	this->reserved_status = UNRESERVED;
+	this->reserved_message_id = (uint32_t)-1;
+	this->reserved_packet_id = (uint32_t)-1;
+	this->clear_route();
+}
@@ -10,8 +10,15 @@
 
 uint32_t global_channel_id;
 
-Channel::Channel (Node* source, Node* dest) {
-	this->channel_id = global_channel_id++;
+bool channel_comp::operator() (const Channel* channel_1, const Channel* channel_2) const {
+	return channel_1->channel_id < channel_2->channel_id;
+}
+
+Channel::Channel (Node* source, Node* dest) : Channel(source, dest, global_channel_id++) {}
+
+// networks built in parallel pass ids that match the serial construction order
+Channel::Channel (Node* source, Node* dest, uint32_t channel_id) {
+	this->channel_id = channel_id;
 	this->source = source;
 	this->dest = dest;
 	this->transmission_state = new Transmission_State;
@@ -19,6 +26,9 @@ Channel::Channel (Node* source, Node* dest) {
 	this->transmission_state->flit_type = HEAD;
 	this->buffer_lst = NULL;
 	this->num_buffers = 0;
+	this->num_flits_carried = 0;
+	this->num_busy_cycles = 0;
+	this->num_blocked_cycles = 0;
 }
 
 void Channel::init_buffer_lst (Buffer** buffer_lst, uint32_t num_buffers) {
@@ -26,11 +36,13 @@ void Channel::init_buffer_lst (Buffer** buffer_lst, uint32_t num_buffers) {
 	this->num_buffers = num_buffers;
 }
 
-bool Channel::is_dest_buffer_reserved_for_flit (Flit* flit) {
+Node* Channel::get_dest () {return this->dest;}
+
+bool Channel::is_dest_buffer_reserved_for_flit (Flit_Handle flit) {
 	bool is_reserved = false;
 	for (uint32_t i=0; i < this->num_buffers; i++) {
 		Buffer* buffer = this->buffer_lst[i];
-		if (buffer->is_reserved_for_flit(flit->message_id, flit->packet_id)) {
+		if (buffer->is_reserved_for_flit(get_flit_message_id(flit), get_flit_packet_id(flit))) {
 			is_reserved = true;
 			break;
 		}
@@ -38,12 +50,12 @@ bool Channel::is_dest_buffer_reserved_for_flit (Flit* flit) {
 	return is_reserved;
 }
 
-bool Channel::is_dest_buffer_reserved_for_flit_and_full (Flit* flit) {
+bool Channel::is_dest_buffer_reserved_for_flit_and_full (Flit_Handle flit) {
 	bool is_reserved = false;
 	bool is_full = false;
 	for (uint32_t i=0; i < this->num_buffers; i++) {
 		Buffer* buffer = this->buffer_lst[i];
-		if (buffer->is_reserved_for_flit(flit->message_id, flit->packet_id)) {
+		if (buffer->is_reserved_for_flit(get_flit_message_id(flit), get_flit_packet_id(flit))) {
 			is_reserved = true;
 			is_full = buffer->is_full();
 			break;
@@ -52,11 +64,15 @@ bool Channel::is_dest_buffer_reserved_for_flit_and_full (Flit* flit) {
 	return is_reserved && is_full;
 }
 
-bool Channel::is_dest_buffer_unreserved () {
+// only counts the virtual channels a HEAD flit is allowed to take
+bool Channel::is_dest_buffer_unreserved (Flit_Handle flit) {
 	bool is_unreserved = false;
-	for (uint32_t i=0; i < this->num_buffers; i++) {
+	uint32_t vc_begin, vc_end;
+	this->get_virtual_channel_range(flit, &vc_begin, &vc_end);
+	bool is_atomic = is_atomic_virtual_channel_allocation();
+	for (uint32_t i=vc_begin; i < vc_end; i++) {
 		Buffer* buffer = this->buffer_lst[i];
-		if (buffer->is_unreserved()) {
+		if (buffer->is_unreserved() && (!is_atomic || buffer->can_accept_packet())) {
 			if (buffer->is_empty() || buffer->is_not_full()) {
 				is_unreserved = true;
 				break;
@@ -75,10 +91,10 @@ void Channel::lock () {
 	this->transmission_state->lock_status = LOCKED;
 }
 
-bool Channel::is_locked_for_flit (Flit* flit) {
+bool Channel::is_locked_for_flit (Flit_Handle flit) {
 	bool is_locked = this->transmission_state->lock_status == LOCKED;
-	bool eq_message_id = this->transmission_state->message_id == flit->message_id;
-	bool eq_packet_id = this->transmission_state->packet_id == flit->packet_id;
+	bool eq_message_id = this->transmission_state->message_id == get_flit_message_id(flit);
+	bool eq_packet_id = this->transmission_state->packet_id == get_flit_packet_id(flit);
 	return is_locked && eq_message_id && eq_packet_id;
 }
 
@@ -87,6 +103,16 @@ bool Channel::is_unlocked () {
 	return is_unlocked;
 }
 
+// a proposal holds the channel until the dest takes the flit, so a HEAD limited to some of the dest
+// virtual channels waits for one of them to open up before it locks the channel against the others
+bool Channel::can_lock_for_flit (Flit_Handle flit) {
+	if (!this->is_unlocked()) return false;
+	uint32_t vc_begin, vc_end;
+	this->get_virtual_channel_range(flit, &vc_begin, &vc_end);
+	if (vc_end - vc_begin == this->num_buffers) return true;
+	return this->is_dest_buffer_unreserved(flit);
+}
+
 bool Channel::is_open_for_transmission () {
 	return this->transmission_state->flit_status == UNASSIGNED;
 }
@@ -104,46 +130,63 @@ void Channel::reset_transmission_state () {
 	this->transmission_state->message_id = (uint32_t)-1;
 }
 
+void Channel::get_virtual_channel_range (Flit_Handle flit, uint32_t* vc_begin, uint32_t* vc_end) {
+	::get_virtual_channel_range(flit, this->source->network_id, this->dest->network_id, this->num_buffers, vc_begin, vc_end);
+}
+
+// clears what the channel carried in a previous run, the source, dest and buffers stay
+void Channel::reset () {
+	this->reset_transmission_state();
+	this->transmission_state->flit_type = HEAD;
+	this->num_flits_carried = 0;
+	this->num_busy_cycles = 0;
+	this->num_blocked_cycles = 0;
+}
+
 void Channel::propose_transmission (Buffer* tx_buffer) {
-	Flit* flit_to_transmit = tx_buffer->peek_flit();
+	Flit_Handle flit_to_transmit = tx_buffer->peek_flit();
 	// if channel is locked, assert that the flit info matches with previous transmission state
 	if (this->transmission_state->lock_status == LOCKED) {
-		assert(this->transmission_state->message_id == flit_to_transmit->message_id);
-		assert(this->transmission_state->packet_id == flit_to_transmit->packet_id);
+		assert(this->transmission_state->message_id == get_flit_message_id(flit_to_transmit));
+		assert(this->transmission_state->packet_id == get_flit_packet_id(flit_to_transmit));
 	}
 	// ensure there is not a flit already placed in this channel
 	assert(this->transmission_state->flit_status == UNASSIGNED);
 	// update transmission state
 	this->transmission_state->tx_buffer = tx_buffer;
 	this->transmission_state->flit_status = ASSIGNED;
-	this->transmission_state->message_id = flit_to_transmit->message_id;
-	this->transmission_state->packet_id = flit_to_transmit->packet_id;
+	this->transmission_state->message_id = get_flit_message_id(flit_to_transmit);
+	this->transmission_state->packet_id = get_flit_packet_id(flit_to_transmit);
+	// dest node has to pull the flit in during this cycle
+	this->dest->schedule();
 }
 
 FLIT_TYPE Channel::execute_transmission (Buffer* rx_buffer) {
 	// pull flit from tx buffer
-	Flit* flit_to_transmit = this->transmission_state->tx_buffer->remove_flit();
+	Flit_Handle flit_to_transmit = this->transmission_state->tx_buffer->remove_flit();
 	// push flit to rx buffer
 	rx_buffer->insert_flit(flit_to_transmit);
 	// set flit status to EMPTY
 	this->transmission_state->flit_status = UNASSIGNED;
 
-	FLIT_TYPE flit_type = flit_to_transmit->type;
+	FLIT_TYPE flit_type = get_flit_type(flit_to_transmit);
 
 	// update distance if transmitting a head flit
-	if (flit_type == HEAD) {
-		Head_Flit* head_flit = (Head_Flit*)flit_to_transmit;
-		head_flit->increment_distance();
-	}
+	if (flit_type == HEAD) increment_flit_distance(flit_to_transmit);
 
-	// erase cached routing if transmitting a tail flit
-	if (flit_type == TAIL && (this->source->type == ROUTER || this->source->type == PROCESSOR_ROUTER)) {
-		Router* router = (Router*)this->source;
-		router->erase_cached_routing(flit_to_transmit->message_id, flit_to_transmit->packet_id);
+	// count the flit for the processor it came from, the processor does not look at this channel during rx
+	if (this->source->type == PROCESSOR) {
+		Processor* processor = (Processor*)this->source;
+		processor->record_flit_transmitted();
 	}
 
+	// the packet has left the tx buffer, so the next HEAD at its front gets routed from scratch
+	if (flit_type == TAIL) this->transmission_state->tx_buffer->clear_route();
+
 	this->transmission_state->transmission_status = SUCCESS;
 	this->transmission_state->flit_type = flit_type;
+	this->num_flits_carried++;
+	this->num_busy_cycles++;
 
 	return flit_type;
 }
@@ -154,6 +197,8 @@ FLIT_TYPE Channel::get_transmitted_flit_type () {
 
 void Channel::fail_transmission () {
 	this->transmission_state->transmission_status = FAIL;
+	this->num_busy_cycles++;
+	this->num_blocked_cycles++;
 	// this->transmission_state->flit_status = UNASSIGNED;
 }
 
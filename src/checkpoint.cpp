@@ -0,0 +1,327 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "checkpoint.h"
+#include "network.h"
+#include "node.h"
+#include "channel.h"
+#include "buffer.h"
+#include "flit.h"
+#include "flit_pool.h"
+#include "message.h"
+#include "completion_tracker.h"
+#include "trace_reader.h"
+
+extern uint32_t global_clock;
+extern Message_Transmission_Info* global_message_transmission_info;
+extern Completion_Tracker* global_completion_tracker;
+
+static void write_padding (FILE* checkpoint_file) {
+	static const char padding[CHECKPOINT_ALIGNMENT] = {0};
+	long offset = ftell(checkpoint_file);
+	uint32_t num_padding_bytes = (CHECKPOINT_ALIGNMENT - offset % CHECKPOINT_ALIGNMENT) % CHECKPOINT_ALIGNMENT;
+	fwrite(padding, 1, num_padding_bytes, checkpoint_file);
+}
+
+static void begin_section (FILE* checkpoint_file, Checkpoint_Header* header, CHECKPOINT_SECTION section) {
+	write_padding(checkpoint_file);
+	header->section_offset[section] = (uint64_t)ftell(checkpoint_file);
+}
+
+// router input buffers in channel id order, then each processor's injection and ejection buffer
+Checkpoint::Checkpoint (Network* network, Trace_Reader* trace_reader, uint32_t num_messages) {
+	this->network = network;
+	this->trace_reader = trace_reader;
+	this->num_messages = num_messages;
+	this->buffer_vec = new std::vector<Buffer*>;
+	this->channel_vec = new std::vector<Channel*>;
+	this->buffer_id_map = new std::map<Buffer*, uint32_t>;
+	this->num_buffer_slots = 0;
+
+	for (uint32_t i=0; i < network->num_routers; i++) {
+		Router* router = network->router_lst[i];
+		for (auto itr=router->input_channel_to_buffers_map->begin(); itr != router->input_channel_to_buffers_map->end(); itr++) {
+			this->channel_vec->push_back(itr->first);
+			for (uint32_t vc=0; vc < router->num_virtual_channels; vc++) this->add_buffer(itr->second[vc]);
+		}
+	}
+	for (uint32_t i=0; i < network->num_processors; i++) {
+		Processor* processor = network->processor_lst[i];
+		this->channel_vec->push_back(processor->get_router_input_channel());
+		this->add_buffer(processor->get_injection_buffer());
+		this->add_buffer(processor->get_router_buffer());
+	}
+}
+
+Checkpoint::~Checkpoint () {
+	delete this->buffer_vec;
+	delete this->channel_vec;
+	delete this->buffer_id_map;
+}
+
+void Checkpoint::add_buffer (Buffer* buffer) {
+	(*this->buffer_id_map)[buffer] = this->buffer_vec->size();
+	this->buffer_vec->push_back(buffer);
+	this->num_buffer_slots += buffer->get_num_slots();
+}
+
+// only called between cycles, so nothing is moving. written next to the target and renamed so a crash never leaves half a checkpoint
+void Checkpoint::save (std::string checkpoint_file_path, Checkpoint_Simulator_State* simulator_state) {
+	std::string tmp_file_path = checkpoint_file_path + ".tmp";
+	FILE* checkpoint_file = fopen(tmp_file_path.c_str(), "wb");
+	assert(checkpoint_file != NULL);
+
+	// sections are filled in as they are written, the header goes out again at the end
+	Checkpoint_Header header;
+	memset(&header, 0, sizeof(Checkpoint_Header));
+	header.magic = CHECKPOINT_MAGIC;
+	header.version = CHECKPOINT_VERSION;
+	header.global_clock = global_clock;
+	header.num_messages = this->num_messages;
+	header.num_processors = this->network->num_processors;
+	header.num_routers = this->network->num_routers;
+	header.num_channels = this->channel_vec->size();
+	header.num_buffers = this->buffer_vec->size();
+	header.num_buffer_slots = this->num_buffer_slots;
+	header.num_packet_chunks = Flit_Pool::get_num_packet_chunks();
+	header.num_batches = global_completion_tracker->get_num_batches();
+	header.trace_next_record = this->trace_reader == NULL ? 0 : this->trace_reader->get_next_id();
+	header.simulator_state = *simulator_state;
+	fwrite(&header, sizeof(Checkpoint_Header), 1, checkpoint_file);
+
+	begin_section(checkpoint_file, &header, CHECKPOINT_MESSAGE_INFO);
+	fwrite(global_message_transmission_info, sizeof(Message_Transmission_Info), this->num_messages, checkpoint_file);
+
+	// a chunk's owner is stored as the owning processor's id
+	std::map<Flit_Pool*, uint32_t> flit_pool_id_map;
+	for (uint32_t i=0; i < this->network->num_processors; i++) flit_pool_id_map[this->network->processor_lst[i]->get_flit_pool()] = i;
+	begin_section(checkpoint_file, &header, CHECKPOINT_PACKET_CHUNKS);
+	for (uint32_t i=0; i < header.num_packet_chunks; i++) {
+		Packet_Chunk chunk = *global_packet_chunk_lst[i];
+		chunk.owner = (Flit_Pool*)(uintptr_t)flit_pool_id_map[chunk.owner];
+		fwrite(&chunk, sizeof(Packet_Chunk), 1, checkpoint_file);
+	}
+
+	begin_section(checkpoint_file, &header, CHECKPOINT_PROCESSORS);
+	for (uint32_t i=0; i < this->network->num_processors; i++) {
+		Processor* processor = this->network->processor_lst[i];
+		Processor_Checkpoint record;
+		processor->get_flit_pool()->save_state(&record.free_lst, &record.released_lst);
+		record.num_flits_transmitted = processor->num_flits_transmitted;
+		record.num_flits_received = processor->num_flits_received;
+		record.num_buffered_flits = processor->num_buffered_flits;
+		record.num_occupied_buffers = processor->num_occupied_buffers;
+		record.num_queued_messages = processor->tx_message_queue->size();
+		record.num_transmitted_messages = processor->transmitted_messages_vec->size();
+		record.num_received_messages = processor->received_messages_vec->size();
+		header.num_queued_messages += record.num_queued_messages;
+		header.num_message_ids += record.num_transmitted_messages + record.num_received_messages;
+		fwrite(&record, sizeof(Processor_Checkpoint), 1, checkpoint_file);
+	}
+
+	begin_section(checkpoint_file, &header, CHECKPOINT_QUEUED_MESSAGES);
+	for (uint32_t i=0; i < this->network->num_processors; i++) {
+		std::deque<Message>* tx_message_queue = this->network->processor_lst[i]->tx_message_queue;
+		for (auto itr=tx_message_queue->begin(); itr != tx_message_queue->end(); itr++) {
+			fwrite(&(*itr), sizeof(Message), 1, checkpoint_file);
+		}
+	}
+
+	begin_section(checkpoint_file, &header, CHECKPOINT_MESSAGE_IDS);
+	for (uint32_t i=0; i < this->network->num_processors; i++) {
+		Processor* processor = this->network->processor_lst[i];
+		fwrite(processor->transmitted_messages_vec->data(), sizeof(uint32_t), processor->transmitted_messages_vec->size(), checkpoint_file);
+		fwrite(processor->received_messages_vec->data(), sizeof(uint32_t), processor->received_messages_vec->size(), checkpoint_file);
+	}
+
+	begin_section(checkpoint_file, &header, CHECKPOINT_ROUTERS);
+	for (uint32_t i=0; i < this->network->num_routers; i++) {
+		Router* router = this->network->router_lst[i];
+		Router_Checkpoint record;
+		record.num_buffered_flits = router->num_buffered_flits;
+		record.num_occupied_buffers = router->num_occupied_buffers;
+		record.num_stalls = router->internal_info_summary->num_stalls;
+		record.total_num_stalls = router->internal_info_summary->total_num_stalls;
+		router->random_stream->save_state(&record.random_stream_state);
+		fwrite(&record, sizeof(Router_Checkpoint), 1, checkpoint_file);
+	}
+
+	begin_section(checkpoint_file, &header, CHECKPOINT_CHANNELS);
+	for (uint32_t i=0; i < this->channel_vec->size(); i++) {
+		Channel* channel = (*this->channel_vec)[i];
+		Transmission_State* transmission_state = channel->transmission_state;
+		Channel_Checkpoint record;
+		record.tx_buffer_id = transmission_state->tx_buffer == NULL ? NO_CHECKPOINT_BUFFER : (*this->buffer_id_map)[transmission_state->tx_buffer];
+		record.flit_status = (uint32_t)transmission_state->flit_status;
+		record.lock_status = (uint32_t)transmission_state->lock_status;
+		record.transmission_status = (uint32_t)transmission_state->transmission_status;
+		record.flit_type = (uint32_t)transmission_state->flit_type;
+		record.packet_id = transmission_state->packet_id;
+		record.message_id = transmission_state->message_id;
+		record.num_flits_carried = channel->num_flits_carried;
+		record.num_busy_cycles = channel->num_busy_cycles;
+		record.num_blocked_cycles = channel->num_blocked_cycles;
+		fwrite(&record, sizeof(Channel_Checkpoint), 1, checkpoint_file);
+	}
+
+	std::vector<Flit_Handle> slot_vec(this->num_buffer_slots);
+	uint32_t slot_offset = 0;
+	begin_section(checkpoint_file, &header, CHECKPOINT_BUFFERS);
+	for (uint32_t i=0; i < this->buffer_vec->size(); i++) {
+		Buffer* buffer = (*this->buffer_vec)[i];
+		Buffer_State state;
+		buffer->save_state(&state, &slot_vec[slot_offset]);
+		slot_offset += buffer->get_num_slots();
+		fwrite(&state, sizeof(Buffer_State), 1, checkpoint_file);
+	}
+
+	begin_section(checkpoint_file, &header, CHECKPOINT_BUFFER_SLOTS);
+	fwrite(slot_vec.data(), sizeof(Flit_Handle), slot_vec.size(), checkpoint_file);
+
+	fseek(checkpoint_file, 0, SEEK_SET);
+	fwrite(&header, sizeof(Checkpoint_Header), 1, checkpoint_file);
+	fclose(checkpoint_file);
+	rename(tmp_file_path.c_str(), checkpoint_file_path.c_str());
+}
+
+// the file is mapped copy on write and stays mapped, packet chunks live in the mapping from here on and message infos are copied out
+void Checkpoint::restore (std::string checkpoint_file_path, Checkpoint_Simulator_State* simulator_state) {
+	int fd = open(checkpoint_file_path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Could Not Open Checkpoint File %s\n", checkpoint_file_path.c_str());
+		exit(1);
+	}
+	struct stat file_stat;
+	fstat(fd, &file_stat);
+	size_t file_size = file_stat.st_size;
+	if (file_size < sizeof(Checkpoint_Header)) {
+		fprintf(stderr, "Checkpoint File %s Is Missing Its Header\n", checkpoint_file_path.c_str());
+		exit(1);
+	}
+	uint8_t* file_data = (uint8_t*)mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	assert(file_data != MAP_FAILED);
+	close(fd);
+
+	Checkpoint_Header* header = (Checkpoint_Header*)file_data;
+	if (header->magic != CHECKPOINT_MAGIC || header->version != CHECKPOINT_VERSION) {
+		fprintf(stderr, "Checkpoint File %s Has An Unknown Format\n", checkpoint_file_path.c_str());
+		exit(1);
+	}
+	if (header->num_messages != this->num_messages ||
+		header->num_processors != this->network->num_processors ||
+		header->num_routers != this->network->num_routers ||
+		header->num_channels != this->channel_vec->size() ||
+		header->num_buffers != this->buffer_vec->size() ||
+		header->num_buffer_slots != this->num_buffer_slots) {
+		fprintf(stderr, "Checkpoint File %s Does Not Match The Configuration\n", checkpoint_file_path.c_str());
+		exit(1);
+	}
+
+	global_clock = header->global_clock;
+	*simulator_state = header->simulator_state;
+	if (this->trace_reader != NULL) this->trace_reader->seek(header->trace_next_record);
+
+	// trace records past the next one have not been released, so their infos are still untouched zeros
+	uint32_t num_created_messages = this->trace_reader == NULL ? this->num_messages : header->trace_next_record;
+	Message_Transmission_Info* message_info_lst = (Message_Transmission_Info*)(file_data + header->section_offset[CHECKPOINT_MESSAGE_INFO]);
+	memcpy(global_message_transmission_info, message_info_lst, num_created_messages * sizeof(Message_Transmission_Info));
+
+	// outstanding and in flight counts follow from the message infos
+	delete global_completion_tracker;
+	global_completion_tracker = new Completion_Tracker(header->num_batches);
+	global_completion_tracker->add_messages(UNTAGGED_BATCH, this->num_messages - num_created_messages);
+	for (uint32_t i=0; i < num_created_messages; i++) {
+		Message_Transmission_Info* message_transmission_info = &global_message_transmission_info[i];
+		if (message_transmission_info->rx_time >= 0) continue;
+		global_completion_tracker->add_messages(message_transmission_info->batch_id, 1);
+		if (message_transmission_info->tx_time >= 0) global_completion_tracker->record_injected();
+	}
+
+	Packet_Chunk* chunk_lst = (Packet_Chunk*)(file_data + header->section_offset[CHECKPOINT_PACKET_CHUNKS]);
+	Packet_Chunk** packet_chunk_lst = new Packet_Chunk*[header->num_packet_chunks];
+	for (uint32_t i=0; i < header->num_packet_chunks; i++) {
+		uint32_t processor_id = (uint32_t)(uintptr_t)chunk_lst[i].owner;
+		assert(processor_id < this->network->num_processors);
+		chunk_lst[i].owner = this->network->processor_lst[processor_id]->get_flit_pool();
+		packet_chunk_lst[i] = &chunk_lst[i];
+	}
+	Flit_Pool::restore_packet_chunks(packet_chunk_lst, header->num_packet_chunks);
+	delete[] packet_chunk_lst;
+
+	Processor_Checkpoint* processor_record_lst = (Processor_Checkpoint*)(file_data + header->section_offset[CHECKPOINT_PROCESSORS]);
+	Message* queued_message_lst = (Message*)(file_data + header->section_offset[CHECKPOINT_QUEUED_MESSAGES]);
+	uint32_t* message_id_lst = (uint32_t*)(file_data + header->section_offset[CHECKPOINT_MESSAGE_IDS]);
+	for (uint32_t i=0; i < this->network->num_processors; i++) {
+		Processor* processor = this->network->processor_lst[i];
+		Processor_Checkpoint* record = &processor_record_lst[i];
+		processor->get_flit_pool()->restore_state(record->free_lst, record->released_lst);
+		processor->num_flits_transmitted = record->num_flits_transmitted;
+		processor->num_flits_received = record->num_flits_received;
+		processor->num_buffered_flits = record->num_buffered_flits;
+		processor->num_occupied_buffers = record->num_occupied_buffers;
+		processor->tx_message_queue->assign(queued_message_lst, queued_message_lst + record->num_queued_messages);
+		queued_message_lst += record->num_queued_messages;
+		processor->transmitted_messages_vec->assign(message_id_lst, message_id_lst + record->num_transmitted_messages);
+		message_id_lst += record->num_transmitted_messages;
+		processor->received_messages_vec->assign(message_id_lst, message_id_lst + record->num_received_messages);
+		message_id_lst += record->num_received_messages;
+	}
+
+	Router_Checkpoint* router_record_lst = (Router_Checkpoint*)(file_data + header->section_offset[CHECKPOINT_ROUTERS]);
+	for (uint32_t i=0; i < this->network->num_routers; i++) {
+		Router* router = this->network->router_lst[i];
+		Router_Checkpoint* record = &router_record_lst[i];
+		router->num_buffered_flits = record->num_buffered_flits;
+		router->num_occupied_buffers = record->num_occupied_buffers;
+		router->internal_info_summary->num_stalls = record->num_stalls;
+		router->internal_info_summary->total_num_stalls = record->total_num_stalls;
+		router->random_stream->restore_state(&record->random_stream_state);
+	}
+
+	// a routed buffer always belongs to a router, its output channels are looked up again by next router id
+	Buffer_State* buffer_state_lst = (Buffer_State*)(file_data + header->section_offset[CHECKPOINT_BUFFERS]);
+	Flit_Handle* slot_lst = (Flit_Handle*)(file_data + header->section_offset[CHECKPOINT_BUFFER_SLOTS]);
+	for (uint32_t i=0; i < this->buffer_vec->size(); i++) {
+		Buffer* buffer = (*this->buffer_vec)[i];
+		Buffer_State* state = &buffer_state_lst[i];
+		buffer->restore_state(state, slot_lst);
+		slot_lst += buffer->get_num_slots();
+		if (state->is_routed) {
+			assert(buffer->owner->type != PROCESSOR);
+			Router* router = (Router*)buffer->owner;
+			buffer->set_route(state->route_next_router_id, router->get_io_channel_vec(state->route_next_router_id));
+		}
+	}
+
+	Channel_Checkpoint* channel_record_lst = (Channel_Checkpoint*)(file_data + header->section_offset[CHECKPOINT_CHANNELS]);
+	for (uint32_t i=0; i < this->channel_vec->size(); i++) {
+		Channel* channel = (*this->channel_vec)[i];
+		Channel_Checkpoint* record = &channel_record_lst[i];
+		Transmission_State* transmission_state = channel->transmission_state;
+		transmission_state->tx_buffer = record->tx_buffer_id == NO_CHECKPOINT_BUFFER ? NULL : (*this->buffer_vec)[record->tx_buffer_id];
+		transmission_state->flit_status = (FLIT_STATUS)record->flit_status;
+		transmission_state->lock_status = (LOCK_STATUS)record->lock_status;
+		transmission_state->transmission_status = (TRANSMISSION_STATUS)record->transmission_status;
+		transmission_state->flit_type = (FLIT_TYPE)record->flit_type;
+		transmission_state->packet_id = record->packet_id;
+		transmission_state->message_id = record->message_id;
+		channel->num_flits_carried = record->num_flits_carried;
+		channel->num_busy_cycles = record->num_busy_cycles;
+		channel->num_blocked_cycles = record->num_blocked_cycles;
+	}
+
+	// the active set only knows about the nodes scheduled during setup, idle nodes drop out again after a cycle
+	for (uint32_t i=0; i < this->network->num_routers; i++) this->network->router_lst[i]->schedule();
+	for (uint32_t i=0; i < this->network->num_processors; i++) this->network->processor_lst[i]->schedule();
+}
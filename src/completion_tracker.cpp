@@ -0,0 +1,82 @@
+#include <stdint.h>
+#include <cassert>
+#include <atomic>
+
+#include "completion_tracker.h"
+
+Completion_Tracker::Completion_Tracker (uint32_t num_batches) {
+	this->num_batches = num_batches;
+	this->batch_counter_lst = new Batch_Counter[this->num_batches];
+	for (uint32_t i=0; i < this->num_batches; i++) {
+		this->batch_counter_lst[i].num_outstanding.store(0);
+	}
+	this->total_counter.num_outstanding.store(0);
+	this->in_flight_counter.num_outstanding.store(0);
+	this->measurement_begin = 0;
+	this->measurement_end = (uint32_t)-1;
+}
+
+Completion_Tracker::~Completion_Tracker () {
+	delete[] this->batch_counter_lst;
+}
+
+uint32_t Completion_Tracker::get_num_batches () {return this->num_batches;}
+
+// only called during setup or a checkpoint restore, before any thread is receiving
+void Completion_Tracker::add_messages (uint32_t batch_id, uint32_t num_messages) {
+	assert(batch_id < this->num_batches);
+	this->batch_counter_lst[batch_id].num_outstanding.fetch_add(num_messages, std::memory_order_relaxed);
+	this->total_counter.num_outstanding.fetch_add(num_messages, std::memory_order_relaxed);
+}
+
+void Completion_Tracker::set_measurement_window (uint32_t measurement_begin, uint32_t measurement_end) {
+	this->measurement_begin = measurement_begin;
+	this->measurement_end = measurement_end;
+}
+
+// called once per message as soon as its creation cycle is set, by setup, the trace release or the source processor
+void Completion_Tracker::record_created (Message_Transmission_Info* message_transmission_info) {
+	assert(message_transmission_info->creation_time >= 0);
+	assert(message_transmission_info->batch_id == UNTAGGED_BATCH);
+	uint32_t creation_time = (uint32_t)message_transmission_info->creation_time;
+	if (creation_time < this->measurement_begin || creation_time >= this->measurement_end) return;
+
+	message_transmission_info->batch_id = TAGGED_BATCH;
+	this->batch_counter_lst[UNTAGGED_BATCH].num_outstanding.fetch_sub(1, std::memory_order_relaxed);
+	this->batch_counter_lst[TAGGED_BATCH].num_outstanding.fetch_add(1, std::memory_order_relaxed);
+}
+
+// called by the source processor when the message's flits go into its injection buffer
+void Completion_Tracker::record_injected () {
+	this->in_flight_counter.num_outstanding.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Completion_Tracker::record_delivered (uint32_t batch_id) {
+	assert(batch_id < this->num_batches);
+	uint32_t num_outstanding = this->batch_counter_lst[batch_id].num_outstanding.fetch_sub(1, std::memory_order_relaxed);
+	assert(num_outstanding > 0);
+	this->total_counter.num_outstanding.fetch_sub(1, std::memory_order_relaxed);
+	this->in_flight_counter.num_outstanding.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// the counts are read between cycles, after the phase barriers
+uint32_t Completion_Tracker::get_num_outstanding () {
+	return this->total_counter.num_outstanding.load(std::memory_order_relaxed);
+}
+
+uint32_t Completion_Tracker::get_num_outstanding (uint32_t batch_id) {
+	assert(batch_id < this->num_batches);
+	return this->batch_counter_lst[batch_id].num_outstanding.load(std::memory_order_relaxed);
+}
+
+uint32_t Completion_Tracker::get_num_in_flight () {
+	return this->in_flight_counter.num_outstanding.load(std::memory_order_relaxed);
+}
+
+bool Completion_Tracker::is_all_delivered () {
+	return this->get_num_outstanding() == 0;
+}
+
+bool Completion_Tracker::is_batch_delivered (uint32_t batch_id) {
+	return this->get_num_outstanding(batch_id) == 0;
+}
@@ -11,10 +11,19 @@ Config_Parser::Config_Parser () {
 	this->parameter_key_to_val_map = new map<string, string>;
 };
 
+Config_Parser::~Config_Parser () {
+	delete this->parameter_key_to_val_map;
+}
+
 void Config_Parser::initialize_parameter_key (string parameter_key) {
 	this->parameter_key_to_val_map->insert({parameter_key, ""});
 }
 
+// optional key, the default is kept if the config file does not set it
+void Config_Parser::initialize_parameter_key (string parameter_key, string default_parameter_value) {
+	this->parameter_key_to_val_map->insert({parameter_key, default_parameter_value});
+}
+
 string Config_Parser::get_string_parameter_value (string parameter_key) {
 	string parameter_val = this->parameter_key_to_val_map->find(parameter_key)->second;
 	return parameter_val;
@@ -26,6 +35,12 @@ uint32_t Config_Parser::get_int_parameter_value (string parameter_key) {
 	return int_parameter_val;
 }
 
+double Config_Parser::get_float_parameter_value (string parameter_key) {
+	string parameter_val = this->parameter_key_to_val_map->find(parameter_key)->second;
+	double float_parameter_val = stod(parameter_val);
+	return float_parameter_val;
+}
+
 void Config_Parser::parse_config_file (string config_file_path) {
 	// open file
 	ifstream config_file(config_file_path);
@@ -39,7 +54,12 @@ void Config_Parser::parse_config_file (string config_file_path) {
 		string parameter_key = config_line.substr(0, colon_idx);
 		string parameter_value = config_line.substr(colon_idx + 2);
 		// parameter_value.pop_back(); // remove trailing newline character
-		this->parameter_key_to_val_map->find(parameter_key)->second = parameter_value;
+		auto itr = this->parameter_key_to_val_map->find(parameter_key);
+		if (itr == this->parameter_key_to_val_map->end()) {
+			cerr << "Ignoring Unknown Config Parameter: " << parameter_key << endl;
+			continue;
+		}
+		itr->second = parameter_value;
 	}
 
 	// close file
@@ -0,0 +1,259 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <cassert>
+#include <vector>
+#include <deque>
+#include <map>
+
+#include "deadlock_detector.h"
+#include "network.h"
+#include "node.h"
+#include "channel.h"
+#include "buffer.h"
+#include "flit.h"
+
+extern uint32_t global_clock;
+
+static uint64_t get_packet_key (uint32_t message_id, uint32_t packet_id) {
+	return ((uint64_t)message_id << 32) | packet_id;
+}
+
+Deadlock_Detector::Deadlock_Detector (Network* network) {
+	this->network = network;
+	this->node_vec = new std::vector<Wait_For_Node>;
+	this->buffer_to_node_map = new std::map<Buffer*, uint32_t>;
+	this->packet_to_node_map = new std::map<uint64_t, std::vector<uint32_t>>;
+	this->deadlocked_node_vec = new std::vector<uint32_t>;
+}
+
+Deadlock_Detector::~Deadlock_Detector () {
+	for (uint32_t i=0; i < this->node_vec->size(); i++) delete (*this->node_vec)[i].wait_for_vec;
+	delete this->node_vec;
+	delete this->buffer_to_node_map;
+	delete this->packet_to_node_map;
+	delete this->deadlocked_node_vec;
+}
+
+// flits that crossed any router input channel or were ejected, only grows while the network makes progress
+uint64_t Deadlock_Detector::count_flit_moves () {
+	uint64_t num_flit_moves = 0;
+	for (uint32_t i=0; i < this->network->num_routers; i++) {
+		Router* router = this->network->router_lst[i];
+		for (auto itr=router->input_channel_to_buffers_map->begin(); itr != router->input_channel_to_buffers_map->end(); itr++) {
+			num_flit_moves += itr->first->num_flits_carried;
+		}
+	}
+	for (uint32_t i=0; i < this->network->num_processors; i++) {
+		num_flit_moves += this->network->processor_lst[i]->num_flits_received;
+	}
+	return num_flit_moves;
+}
+
+void Deadlock_Detector::build_wait_for_graph () {
+	for (uint32_t i=0; i < this->node_vec->size(); i++) delete (*this->node_vec)[i].wait_for_vec;
+	this->node_vec->clear();
+	this->buffer_to_node_map->clear();
+	this->packet_to_node_map->clear();
+
+	for (uint32_t i=0; i < this->network->num_routers; i++) {
+		Router* router = this->network->router_lst[i];
+		for (auto itr=router->input_channel_to_buffers_map->begin(); itr != router->input_channel_to_buffers_map->end(); itr++) {
+			for (uint32_t vc=0; vc < router->num_virtual_channels; vc++) {
+				Wait_For_Node node;
+				node.router = router;
+				node.input_channel = itr->first;
+				node.vc = vc;
+				node.buffer = itr->second[vc];
+				node.can_progress = false;
+				node.wait_for_vec = new std::vector<uint32_t>;
+				(*this->buffer_to_node_map)[node.buffer] = this->node_vec->size();
+				// flits of a packet are back to back, so each packet is only added once per buffer
+				uint64_t prev_packet_key = (uint64_t)-1;
+				for (auto itr_flit=node.buffer->begin(); itr_flit != node.buffer->end(); itr_flit++) {
+					uint64_t packet_key = get_packet_key(get_flit_message_id(*itr_flit), get_flit_packet_id(*itr_flit));
+					if (packet_key != prev_packet_key) (*this->packet_to_node_map)[packet_key].push_back(this->node_vec->size());
+					prev_packet_key = packet_key;
+				}
+				this->node_vec->push_back(node);
+			}
+		}
+	}
+
+	for (uint32_t i=0; i < this->node_vec->size(); i++) this->add_wait_for_edges(i);
+}
+
+void Deadlock_Detector::add_wait_for_edges (uint32_t node_id) {
+	Wait_For_Node* node = &(*this->node_vec)[node_id];
+	Buffer* buffer = node->buffer;
+
+	if (buffer->is_empty()) {
+		// an empty virtual channel with space is free, a reserved one waits for the rest of its packet to arrive
+		if (buffer->is_unreserved()) {
+			node->can_progress = true;
+			return;
+		}
+		uint64_t reserved_packet_key = get_packet_key(buffer->get_reserved_message_id(), buffer->get_reserved_packet_id());
+		auto itr_packet = this->packet_to_node_map->find(reserved_packet_key);
+		if (itr_packet != this->packet_to_node_map->end()) *node->wait_for_vec = itr_packet->second;
+		// the rest of the packet is still in its source processor, which injects as soon as there is space
+		if (node->wait_for_vec->empty()) node->can_progress = true;
+		return;
+	}
+
+	// nothing to go on if the front flit was never routed
+	if (!buffer->is_routed) {
+		node->can_progress = true;
+		return;
+	}
+
+	Flit_Handle flit = buffer->peek_flit();
+	Router* router = node->router;
+	std::vector<IO_Channel*>* io_channel_vec = buffer->route_io_channel_vec;
+	for (auto itr_io_channel=io_channel_vec->begin(); itr_io_channel != io_channel_vec->end(); itr_io_channel++) {
+		Channel* output_channel = (*itr_io_channel)->output_channel;
+		Node* dest = output_channel->get_dest();
+
+		// processors always take their flits
+		if (dest->type == PROCESSOR) {
+			node->can_progress = true;
+			return;
+		}
+
+		// a channel locked to another packet opens up once that packet's tail has crossed it
+		if (router->flow_control_granularity == PACKET && !output_channel->is_unlocked() && !output_channel->is_locked_for_flit(flit)) {
+			uint64_t locked_packet_key = get_packet_key(output_channel->transmission_state->message_id, output_channel->transmission_state->packet_id);
+			uint32_t num_wait_for = node->wait_for_vec->size();
+			auto itr_packet = this->packet_to_node_map->find(locked_packet_key);
+			if (itr_packet != this->packet_to_node_map->end()) {
+				for (uint32_t i=0; i < itr_packet->second.size(); i++) {
+					if ((*this->node_vec)[itr_packet->second[i]].router == router) node->wait_for_vec->push_back(itr_packet->second[i]);
+				}
+			}
+			if (node->wait_for_vec->size() == num_wait_for) {
+				node->can_progress = true;
+				return;
+			}
+			continue;
+		}
+
+		Router* dest_router = (Router*)dest;
+		Buffer** dest_buffers = dest_router->input_channel_to_buffers_map->at(output_channel);
+		bool is_reserved = false;
+		for (uint32_t vc=0; vc < dest_router->num_virtual_channels; vc++) {
+			Buffer* dest_buffer = dest_buffers[vc];
+			if (dest_buffer->is_reserved_for_flit(get_flit_message_id(flit), get_flit_packet_id(flit))) {
+				is_reserved = true;
+				if (!dest_buffer->is_full()) {
+					node->can_progress = true;
+					return;
+				}
+				node->wait_for_vec->push_back((*this->buffer_to_node_map)[dest_buffer]);
+				break;
+			}
+		}
+		if (is_reserved) continue;
+
+		// a head needs any virtual channel it may take that is unreserved and has space
+		uint32_t vc_begin, vc_end;
+		output_channel->get_virtual_channel_range(flit, &vc_begin, &vc_end);
+		bool is_atomic = is_atomic_virtual_channel_allocation();
+		for (uint32_t vc=vc_begin; vc < vc_end; vc++) {
+			Buffer* dest_buffer = dest_buffers[vc];
+			if (dest_buffer->is_unreserved() && (is_atomic ? dest_buffer->is_empty() : !dest_buffer->is_full())) {
+				node->can_progress = true;
+				return;
+			}
+			node->wait_for_vec->push_back((*this->buffer_to_node_map)[dest_buffer]);
+		}
+	}
+
+	// no edges means the flit is not waiting on anything we know about
+	if (node->wait_for_vec->empty()) node->can_progress = true;
+}
+
+// a node can progress once any node it waits on can
+void Deadlock_Detector::propagate_progress () {
+	std::vector<std::vector<uint32_t>> waiter_vecs(this->node_vec->size());
+	std::deque<uint32_t> progress_queue;
+	for (uint32_t i=0; i < this->node_vec->size(); i++) {
+		Wait_For_Node* node = &(*this->node_vec)[i];
+		for (uint32_t j=0; j < node->wait_for_vec->size(); j++) waiter_vecs[(*node->wait_for_vec)[j]].push_back(i);
+		if (node->can_progress) progress_queue.push_back(i);
+	}
+	while (!progress_queue.empty()) {
+		uint32_t node_id = progress_queue.front();
+		progress_queue.pop_front();
+		for (uint32_t i=0; i < waiter_vecs[node_id].size(); i++) {
+			Wait_For_Node* waiter = &(*this->node_vec)[waiter_vecs[node_id][i]];
+			if (waiter->can_progress) continue;
+			waiter->can_progress = true;
+			progress_queue.push_back(waiter_vecs[node_id][i]);
+		}
+	}
+}
+
+// every node that can not progress only waits on nodes that can not progress either, so a walk has to come back around
+bool Deadlock_Detector::find_cycle (std::vector<uint32_t>* cycle_vec) {
+	cycle_vec->clear();
+	if (this->deadlocked_node_vec->empty()) return false;
+	std::map<uint32_t, uint32_t> walk_position_map;
+	std::vector<uint32_t> walk_vec;
+	uint32_t node_id = (*this->deadlocked_node_vec)[0];
+	while (walk_position_map.find(node_id) == walk_position_map.end()) {
+		walk_position_map[node_id] = walk_vec.size();
+		walk_vec.push_back(node_id);
+		Wait_For_Node* node = &(*this->node_vec)[node_id];
+		uint32_t next_node_id = (uint32_t)-1;
+		for (uint32_t i=0; i < node->wait_for_vec->size(); i++) {
+			if (!(*this->node_vec)[(*node->wait_for_vec)[i]].can_progress) {
+				next_node_id = (*node->wait_for_vec)[i];
+				break;
+			}
+		}
+		assert(next_node_id != (uint32_t)-1);
+		node_id = next_node_id;
+	}
+	cycle_vec->assign(walk_vec.begin() + walk_position_map[node_id], walk_vec.end());
+	return true;
+}
+
+// number of non empty virtual channels whose flits can never move again
+uint32_t Deadlock_Detector::detect () {
+	this->build_wait_for_graph();
+	this->propagate_progress();
+	this->deadlocked_node_vec->clear();
+	for (uint32_t i=0; i < this->node_vec->size(); i++) {
+		Wait_For_Node* node = &(*this->node_vec)[i];
+		if (!node->can_progress && !node->buffer->is_empty()) this->deadlocked_node_vec->push_back(i);
+	}
+	return this->deadlocked_node_vec->size();
+}
+
+// only called once detect has found stuck virtual channels, which always wait on each other in a cycle
+void Deadlock_Detector::report (FILE* file) {
+	std::vector<uint32_t> cycle_vec;
+	this->find_cycle(&cycle_vec);
+	assert(!cycle_vec.empty());
+	fprintf(file, "Deadlock Detected at Clock Cycle %d: %d Virtual Channels Can Never Move Again\n", global_clock, (uint32_t)this->deadlocked_node_vec->size());
+	fprintf(file, "Wait-For Cycle:\n");
+	for (uint32_t i=0; i < cycle_vec.size(); i++) {
+		Wait_For_Node* node = &(*this->node_vec)[cycle_vec[i]];
+		Buffer* buffer = node->buffer;
+		if (buffer->is_empty()) {
+			fprintf(file, "\tRouter %d Input Channel %d VC %d Reserved for Message %d Packet %d\n", node->router->node_id, node->input_channel->channel_id, node->vc,
+					buffer->get_reserved_message_id(), buffer->get_reserved_packet_id());
+		}
+		else {
+			Flit_Handle flit = buffer->peek_flit();
+			fprintf(file, "\tRouter %d Input Channel %d VC %d Holding Message %d Packet %d (%d Flits)\n", node->router->node_id, node->input_channel->channel_id, node->vc,
+					get_flit_message_id(flit), get_flit_packet_id(flit), buffer->occupied_size());
+		}
+	}
+	fprintf(file, "Deadlocked Virtual Channels:\n");
+	for (uint32_t i=0; i < this->deadlocked_node_vec->size(); i++) {
+		Wait_For_Node* node = &(*this->node_vec)[(*this->deadlocked_node_vec)[i]];
+		Flit_Handle flit = node->buffer->peek_flit();
+		fprintf(file, "\tRouter %d Input Channel %d VC %d Holding Message %d Packet %d\n", node->router->node_id, node->input_channel->channel_id, node->vc,
+				get_flit_message_id(flit), get_flit_packet_id(flit));
+	}
+}
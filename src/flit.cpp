@@ -1,51 +1,20 @@
 #include <stdint.h>
+#include <stdlib.h>
 
 #include "flit.h"
 
-Flit::Flit(uint32_t flit_id, uint32_t packet_id, uint32_t message_id, uint32_t num_packets, FLIT_TYPE type) {
-	this->flit_id = flit_id;
-	this->packet_id = packet_id;
-	this->message_id = message_id;
-	this->num_packets = num_packets;
-	this->type = type;
-}
-
-Border_Flit::Border_Flit(uint32_t flit_id, 
-						 uint32_t packet_id, 
-						 uint32_t message_id, 
-						 uint32_t num_packets,
-						 FLIT_TYPE type, 
-						 uint32_t source, 
-						 uint32_t dest) :
-Flit(flit_id, packet_id, message_id, num_packets, type) {
-	this->type = type;
-	this->source = source;
-	this->dest = dest;
-}
+Packet_Chunk** global_packet_chunk_lst;
+uint32_t flit_index_bits;
+uint32_t tail_flit_index;
 
-Head_Flit::Head_Flit(uint32_t flit_id, 
-					 uint32_t packet_id, 
-					 uint32_t message_id, 
-					 uint32_t num_packets,
-					 uint32_t source, 
-					 uint32_t dest) : 
-Border_Flit(flit_id, packet_id, message_id, num_packets, HEAD, source, dest) {}
+// sizes the handle fields for this packet length and reserves the chunk directory
+void init_flit_table(uint32_t num_data_flits_per_packet) {
+	tail_flit_index = num_data_flits_per_packet + 1;
+	flit_index_bits = 1;
+	while ((1u << flit_index_bits) <= tail_flit_index) flit_index_bits++;
 
-void Head_Flit::increment_distance() {
-	this->distance += 1;
+	// directory covers every packet slot a handle can address, untouched entries are never paged in
+	uint32_t num_packet_slot_bits = 32 - flit_index_bits;
+	uint32_t max_num_packet_chunks = 1u << (num_packet_slot_bits - PACKET_CHUNK_BITS);
+	global_packet_chunk_lst = (Packet_Chunk**)calloc(max_num_packet_chunks, sizeof(Packet_Chunk*));
 }
-
-Tail_Flit::Tail_Flit(uint32_t flit_id, 
-					 uint32_t packet_id, 
-					 uint32_t message_id, 
-					 uint32_t num_packets,
-					 uint32_t source, 
-					 uint32_t dest) : 
-Border_Flit(flit_id, packet_id, message_id, num_packets, TAIL, source, dest) {}
-
-Data_Flit::Data_Flit(uint32_t flit_id, 
-					 uint32_t packet_id, 
-					 uint32_t message_id,
-					 uint32_t num_packets) :
-Flit(flit_id, packet_id, message_id, num_packets, DATA) {}
-
@@ -0,0 +1,102 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <cassert>
+#include <atomic>
+
+#include "flit_pool.h"
+#include "flit.h"
+
+extern uint32_t flit_index_bits;
+
+static std::atomic<uint32_t> num_packet_chunks(0);
+
+Flit_Pool::Flit_Pool () {
+	this->free_lst = NO_PACKET_SLOT;
+	this->released_lst.store(NO_PACKET_SLOT);
+	// first chunk is touched by the thread that builds the processor
+	this->grow();
+}
+
+void Flit_Pool::grow () {
+	uint32_t chunk_id = num_packet_chunks.fetch_add(1);
+	assert(chunk_id < (1u << (32 - flit_index_bits - PACKET_CHUNK_BITS)));
+	Packet_Chunk* chunk = new Packet_Chunk;
+	chunk->owner = this;
+	for (uint32_t i=0; i < PACKET_CHUNK_SIZE; i++) {
+		chunk->next_free[i] = this->free_lst;
+		this->free_lst = (chunk_id << PACKET_CHUNK_BITS) | i;
+	}
+	global_packet_chunk_lst[chunk_id] = chunk;
+}
+
+uint32_t Flit_Pool::new_packet (uint32_t message_id, uint32_t packet_id, uint32_t num_packets, uint32_t dest) {
+	// take back every slot released since the free list last ran out
+	if (this->free_lst == NO_PACKET_SLOT) this->free_lst = this->released_lst.exchange(NO_PACKET_SLOT, std::memory_order_acquire);
+	if (this->free_lst == NO_PACKET_SLOT) this->grow();
+
+	uint32_t packet_slot = this->free_lst;
+	Packet_Chunk* chunk = global_packet_chunk_lst[packet_slot >> PACKET_CHUNK_BITS];
+	uint32_t offset = packet_slot & (PACKET_CHUNK_SIZE - 1);
+	this->free_lst = chunk->next_free[offset];
+
+	chunk->message_id[offset] = message_id;
+	chunk->packet_id[offset] = packet_id;
+	chunk->num_packets[offset] = num_packets;
+	chunk->dest[offset] = dest;
+	chunk->distance[offset] = 0;
+	return packet_slot;
+}
+
+// called once the tail flit is ejected, nothing refers to the packet after that
+void Flit_Pool::release_packet (uint32_t packet_slot) {
+	Packet_Chunk* chunk = global_packet_chunk_lst[packet_slot >> PACKET_CHUNK_BITS];
+	uint32_t offset = packet_slot & (PACKET_CHUNK_SIZE - 1);
+	Flit_Pool* owner = chunk->owner;
+	uint32_t head = owner->released_lst.load(std::memory_order_relaxed);
+	do {
+		chunk->next_free[offset] = head;
+	} while (!owner->released_lst.compare_exchange_weak(head, packet_slot, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void Flit_Pool::save_state (uint32_t* free_lst, uint32_t* released_lst) {
+	*free_lst = this->free_lst;
+	*released_lst = this->released_lst.load(std::memory_order_relaxed);
+}
+
+void Flit_Pool::restore_state (uint32_t free_lst, uint32_t released_lst) {
+	this->free_lst = free_lst;
+	this->released_lst.store(released_lst, std::memory_order_relaxed);
+}
+
+uint32_t Flit_Pool::get_num_packet_chunks () {
+	return num_packet_chunks.load(std::memory_order_relaxed);
+}
+
+// flit handles name their chunk by index, so restored chunks take the same indices and later ones follow on
+void Flit_Pool::restore_packet_chunks (Packet_Chunk** packet_chunk_lst, uint32_t num_restored_chunks) {
+	uint32_t num_old_chunks = num_packet_chunks.load(std::memory_order_relaxed);
+	for (uint32_t i=0; i < num_old_chunks; i++) {
+		delete global_packet_chunk_lst[i];
+		global_packet_chunk_lst[i] = NULL;
+	}
+	for (uint32_t i=0; i < num_restored_chunks; i++) global_packet_chunk_lst[i] = packet_chunk_lst[i];
+	num_packet_chunks.store(num_restored_chunks, std::memory_order_relaxed);
+}
+
+// the pool forgets its slots until reset_packet_chunks hands every chunk back to its owner
+void Flit_Pool::reset () {
+	this->free_lst = NO_PACKET_SLOT;
+	this->released_lst.store(NO_PACKET_SLOT, std::memory_order_relaxed);
+}
+
+// chunks keep their owner and index, so a reset network allocates from the chunks it already grew
+void Flit_Pool::reset_packet_chunks () {
+	uint32_t num_chunks = num_packet_chunks.load(std::memory_order_relaxed);
+	for (uint32_t chunk_id=0; chunk_id < num_chunks; chunk_id++) {
+		Packet_Chunk* chunk = global_packet_chunk_lst[chunk_id];
+		for (uint32_t i=0; i < PACKET_CHUNK_SIZE; i++) {
+			chunk->next_free[i] = chunk->owner->free_lst;
+			chunk->owner->free_lst = (chunk_id << PACKET_CHUNK_BITS) | i;
+		}
+	}
+}
@@ -8,18 +8,15 @@
 /* flow control algorithms */
 
 // only return true if the entire packet is inside the buffer
-bool store_forward_flow_control (Flit* flit, Buffer* buffer) {
+bool store_forward_flow_control (Flit_Handle flit, Buffer* buffer) {
 	// if this is not a head flit, then this means that the head flit of the packet
 	// has already been transmitted, so we can transmit this flit
-	if (flit->type != HEAD) return true;
+	if (get_flit_type(flit) != HEAD) return true;
 
 	// this is a head flit so need to check if the corresponding tail flit is inside the buffer
+	Flit_Handle tail_flit = make_flit_handle(get_flit_packet_slot(flit), tail_flit_index);
 	for (auto itr=buffer->begin(); itr != buffer->end(); itr++) {
-		Flit* test_flit = *itr;
-		if (test_flit->message_id == flit->message_id && 
-			test_flit->packet_id == flit->packet_id &&
-			test_flit->type == TAIL) 
-			return true;
+		if (*itr == tail_flit) return true;
 	}
 
 	// entire packet is no queued up in buffer
@@ -28,6 +25,6 @@ bool store_forward_flow_control (Flit* flit, Buffer* buffer) {
 }
 
 // always return true because transmission does not have to wait on anything
-bool cut_through_flow_control (Flit* flit, Buffer* buffer) {
+bool cut_through_flow_control (Flit_Handle flit, Buffer* buffer) {
 	return true;
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <cassert>
+#include <string>
+#include <vector>
+
+#include "heatmap_writer.h"
+#include "node.h"
+#include "channel.h"
+#include "buffer.h"
+
+Heatmap_Writer::Heatmap_Writer (std::string heatmap_file_path, uint32_t num_rows, uint32_t num_cols, uint32_t num_ports, uint32_t num_virtual_channels) {
+	this->heatmap_file = fopen(heatmap_file_path.c_str(), "wb");
+	assert(this->heatmap_file != NULL);
+
+	// snapshot count is filled in on close
+	this->header.magic = HEATMAP_MAGIC;
+	this->header.version = HEATMAP_VERSION;
+	this->header.num_rows = num_rows;
+	this->header.num_cols = num_cols;
+	this->header.num_ports = num_ports;
+	this->header.num_virtual_channels = num_virtual_channels;
+	this->header.num_snapshots = 0;
+	this->header.reserved = 0;
+	fwrite(&this->header, sizeof(Heatmap_Header), 1, this->heatmap_file);
+
+	this->snapshot_vec = new std::vector<uint32_t>;
+}
+
+Heatmap_Writer::~Heatmap_Writer () {
+	delete this->snapshot_vec;
+}
+
+void Heatmap_Writer::begin_snapshot (uint32_t cycle) {
+	this->snapshot_vec->clear();
+	this->snapshot_vec->push_back(cycle);
+	this->snapshot_vec->push_back(0);
+}
+
+// a NULL channel is a port the router does not have, buffers past num_buffers are written as zeros
+void Heatmap_Writer::append_port (Channel* channel, Buffer** buffers, uint32_t num_buffers) {
+	assert(num_buffers <= this->header.num_virtual_channels);
+	this->snapshot_vec->push_back(channel == NULL ? 0 : channel->num_flits_carried);
+	this->snapshot_vec->push_back(channel == NULL ? 0 : channel->num_busy_cycles);
+	this->snapshot_vec->push_back(channel == NULL ? 0 : channel->num_blocked_cycles);
+	this->snapshot_vec->push_back(channel != NULL);
+	for (uint32_t i=0; i < this->header.num_virtual_channels; i++) {
+		uint64_t occupancy_sum = i < num_buffers ? buffers[i]->occupancy_sum : 0;
+		this->snapshot_vec->push_back((uint32_t)occupancy_sum);
+		this->snapshot_vec->push_back((uint32_t)(occupancy_sum >> 32));
+		this->snapshot_vec->push_back(i < num_buffers ? buffers[i]->num_blocked_cycles : 0);
+		this->snapshot_vec->push_back(0);
+	}
+}
+
+void Heatmap_Writer::end_snapshot () {
+	uint32_t num_port_words = 4 + 4*this->header.num_virtual_channels;
+	assert(this->snapshot_vec->size() == 2 + this->header.num_rows*this->header.num_cols*this->header.num_ports*num_port_words);
+	fwrite(this->snapshot_vec->data(), sizeof(uint32_t), this->snapshot_vec->size(), this->heatmap_file);
+	this->header.num_snapshots++;
+}
+
+void Heatmap_Writer::close () {
+	fseek(this->heatmap_file, 0, SEEK_SET);
+	fwrite(&this->header, sizeof(Heatmap_Header), 1, this->heatmap_file);
+	fclose(this->heatmap_file);
+}
@@ -0,0 +1,155 @@
+#include <stdint.h>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+
+#include "latency_histogram.h"
+
+#define NUM_EXACT_BUCKETS (1u << LATENCY_SUB_BUCKET_BITS)
+#define NUM_SUB_BUCKETS (1u << (LATENCY_SUB_BUCKET_BITS - 1))
+
+Latency_Histogram::Latency_Histogram () {
+	this->count_vec = new std::vector<uint32_t>;
+	this->total_count = 0;
+	this->max_latency = 0;
+}
+
+Latency_Histogram::~Latency_Histogram () {
+	delete this->count_vec;
+}
+
+void Latency_Histogram::record (uint32_t latency) {
+	uint32_t bucket_index = get_bucket_index(latency);
+	if (bucket_index >= this->count_vec->size()) this->count_vec->resize(bucket_index + 1, 0);
+	(*this->count_vec)[bucket_index]++;
+	this->total_count++;
+	this->max_latency = std::max(this->max_latency, latency);
+}
+
+void Latency_Histogram::merge (Latency_Histogram* histogram) {
+	if (histogram->count_vec->size() > this->count_vec->size()) this->count_vec->resize(histogram->count_vec->size(), 0);
+	for (uint32_t i=0; i < histogram->count_vec->size(); i++) {
+		(*this->count_vec)[i] += (*histogram->count_vec)[i];
+	}
+	this->total_count += histogram->total_count;
+	this->max_latency = std::max(this->max_latency, histogram->max_latency);
+}
+
+uint32_t Latency_Histogram::get_total_count () {return this->total_count;}
+uint32_t Latency_Histogram::get_max_latency () {return this->max_latency;}
+uint32_t Latency_Histogram::get_num_buckets () {return this->count_vec->size();}
+uint32_t Latency_Histogram::get_bucket_count (uint32_t bucket_index) {return (*this->count_vec)[bucket_index];}
+
+// highest latency the bucket holding the percentile'th message could have, never more than the max seen
+uint32_t Latency_Histogram::get_percentile (double percentile) {
+	if (this->total_count == 0) return 0;
+	uint64_t rank = (uint64_t)(percentile / 100.0 * this->total_count + 0.999999);
+	rank = std::max(rank, (uint64_t)1);
+	uint64_t num_counted = 0;
+	for (uint32_t i=0; i < this->count_vec->size(); i++) {
+		num_counted += (*this->count_vec)[i];
+		if (num_counted >= rank) return std::min(get_bucket_high(i), this->max_latency);
+	}
+	return this->max_latency;
+}
+
+uint32_t Latency_Histogram::get_bucket_index (uint32_t latency) {
+	if (latency < NUM_EXACT_BUCKETS) return latency;
+	uint32_t magnitude = 31 - __builtin_clz(latency);
+	uint32_t shift = magnitude - LATENCY_SUB_BUCKET_BITS + 1;
+	uint32_t sub_bucket = (latency >> shift) - NUM_SUB_BUCKETS;
+	return NUM_EXACT_BUCKETS + (magnitude - LATENCY_SUB_BUCKET_BITS) * NUM_SUB_BUCKETS + sub_bucket;
+}
+
+uint32_t Latency_Histogram::get_bucket_low (uint32_t bucket_index) {
+	if (bucket_index < NUM_EXACT_BUCKETS) return bucket_index;
+	uint32_t shift = (bucket_index - NUM_EXACT_BUCKETS) / NUM_SUB_BUCKETS + 1;
+	uint32_t sub_bucket = (bucket_index - NUM_EXACT_BUCKETS) % NUM_SUB_BUCKETS + NUM_SUB_BUCKETS;
+	return sub_bucket << shift;
+}
+
+uint32_t Latency_Histogram::get_bucket_high (uint32_t bucket_index) {
+	if (bucket_index < NUM_EXACT_BUCKETS) return bucket_index;
+	uint32_t shift = (bucket_index - NUM_EXACT_BUCKETS) / NUM_SUB_BUCKETS + 1;
+	return get_bucket_low(bucket_index) + ((1u << shift) - 1);
+}
+
+
+
+// class 0 is global, then the distance classes, then the region pairs in source major order
+Latency_Histogram_Set::Latency_Histogram_Set (uint32_t num_processors, uint32_t num_regions) {
+	assert(num_regions > 0);
+	this->num_processors = num_processors;
+	this->num_regions = std::min(num_regions, num_processors);
+	this->num_classes = 1 + NUM_DISTANCE_CLASSES + this->num_regions * this->num_regions;
+	this->histogram_lst = new Latency_Histogram*[this->num_classes];
+	for (uint32_t i=0; i < this->num_classes; i++) this->histogram_lst[i] = NULL;
+}
+
+Latency_Histogram_Set::~Latency_Histogram_Set () {
+	for (uint32_t i=0; i < this->num_classes; i++) delete this->histogram_lst[i];
+	delete[] this->histogram_lst;
+}
+
+Latency_Histogram* Latency_Histogram_Set::get_or_create_histogram (uint32_t class_index) {
+	if (this->histogram_lst[class_index] == NULL) this->histogram_lst[class_index] = new Latency_Histogram();
+	return this->histogram_lst[class_index];
+}
+
+void Latency_Histogram_Set::record (uint32_t latency, uint32_t distance, uint32_t source, uint32_t dest) {
+	uint32_t region_pair = this->get_region(source) * this->num_regions + this->get_region(dest);
+	this->get_or_create_histogram(0)->record(latency);
+	this->get_or_create_histogram(1 + get_distance_class(distance))->record(latency);
+	this->get_or_create_histogram(1 + NUM_DISTANCE_CLASSES + region_pair)->record(latency);
+}
+
+void Latency_Histogram_Set::merge (Latency_Histogram_Set* histogram_set) {
+	assert(histogram_set->num_classes == this->num_classes);
+	for (uint32_t i=0; i < this->num_classes; i++) {
+		if (histogram_set->histogram_lst[i] == NULL) continue;
+		this->get_or_create_histogram(i)->merge(histogram_set->histogram_lst[i]);
+	}
+}
+
+uint32_t Latency_Histogram_Set::get_num_classes () {return this->num_classes;}
+
+// NULL if no message of the class was received
+Latency_Histogram* Latency_Histogram_Set::get_histogram (uint32_t class_index) {
+	assert(class_index < this->num_classes);
+	return this->histogram_lst[class_index];
+}
+
+LATENCY_CLASS_KIND Latency_Histogram_Set::get_class_kind (uint32_t class_index) {
+	if (class_index == 0) return GLOBAL_LATENCY_CLASS;
+	if (class_index < 1 + NUM_DISTANCE_CLASSES) return DISTANCE_LATENCY_CLASS;
+	return REGION_LATENCY_CLASS;
+}
+
+// hop range for a distance class, source and destination region for a region pair
+void Latency_Histogram_Set::get_class_range (uint32_t class_index, uint32_t* class_low, uint32_t* class_high) {
+	LATENCY_CLASS_KIND class_kind = this->get_class_kind(class_index);
+	if (class_kind == GLOBAL_LATENCY_CLASS) {
+		*class_low = 0;
+		*class_high = (uint32_t)-1;
+	}
+	else if (class_kind == DISTANCE_LATENCY_CLASS) {
+		uint32_t distance_class = class_index - 1;
+		*class_low = distance_class == 0 ? 0 : 1u << (distance_class - 1);
+		*class_high = distance_class == 0 ? 0 : (distance_class == NUM_DISTANCE_CLASSES - 1 ? (uint32_t)-1 : (1u << distance_class) - 1);
+	}
+	else {
+		uint32_t region_pair = class_index - 1 - NUM_DISTANCE_CLASSES;
+		*class_low = region_pair / this->num_regions;
+		*class_high = region_pair % this->num_regions;
+	}
+}
+
+uint32_t Latency_Histogram_Set::get_region (uint32_t processor_id) {
+	return (uint32_t)((uint64_t)processor_id * this->num_regions / this->num_processors);
+}
+
+uint32_t Latency_Histogram_Set::get_distance_class (uint32_t distance) {
+	if (distance == 0) return 0;
+	uint32_t distance_class = 32 - __builtin_clz(distance);
+	return std::min(distance_class, (uint32_t)NUM_DISTANCE_CLASSES - 1);
+}
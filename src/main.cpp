@@ -7,16 +7,22 @@
 #include <algorithm>
 
 #include "simulator.h"
+#include "random_stream.h"
+#include "sweep_runner.h"
 
 int main(int argc, char **argv) {
-	srand(15418);
-
 	int num_threads = 1;
+	uint32_t seed = 15418;
+	bool is_deterministic = false;
 	string config_file_path = "";
 	bool is_verbose = false;
+	SIMULATION_ENGINE engine = FULL_SWEEP;
+	string checkpoint_file_path = "";
+	string sweep_spec_file_path = "";
+	uint32_t num_jobs = 0;
 
 	int opt;
-	while ((opt = getopt(argc, argv, "vt:p:")) != -1) {
+	while ((opt = getopt(argc, argv, "vdt:p:e:s:r:w:j:")) != -1) {
 		switch (opt) {
 			case 't': {
 				num_threads = atoi(optarg);
@@ -30,18 +36,60 @@ int main(int argc, char **argv) {
 				is_verbose = true;
 				break;
 			}
+			case 'd': {
+				is_deterministic = true;
+				break;
+			}
+			case 's': {
+				seed = (uint32_t)atoi(optarg);
+				break;
+			}
+			case 'r': {
+				checkpoint_file_path = optarg;
+				break;
+			}
+			case 'w': {
+				sweep_spec_file_path = optarg;
+				break;
+			}
+			case 'j': {
+				num_jobs = (uint32_t)atoi(optarg);
+				break;
+			}
+			case 'e': {
+				string engine_str = optarg;
+				if (engine_str.compare("sweep") == 0) engine = FULL_SWEEP;
+				else if (engine_str.compare("active") == 0) engine = ACTIVE_SET;
+				else if (engine_str.compare("pool") == 0) engine = WORKER_POOL;
+				else {
+					fprintf(stderr, "Unknown simulation engine %s (expected sweep, active or pool)\n", optarg);
+					return 1;
+				}
+				break;
+			}
 		}
 	}
 
+	// a sweep runs each config in its own process, -p is where the results go and -t the threads per config
+	if (sweep_spec_file_path.compare("") != 0) {
+		Sweep_Runner sweep_runner(sweep_spec_file_path, config_file_path, num_jobs, num_threads, engine, seed, is_deterministic);
+		uint32_t num_failed = sweep_runner.run();
+		return num_failed > 0 ? 1 : 0;
+	}
+
 	omp_set_num_threads(num_threads);
+	init_random_streams(seed, is_deterministic);
 
 	double start_time = CycleTimer::currentSeconds();
-	Simulator test = Simulator(config_file_path, is_verbose);
+	Simulator test = Simulator(config_file_path, is_verbose, engine, 0);
 	test.setup();
+	if (checkpoint_file_path.compare("") != 0) test.restore_checkpoint(checkpoint_file_path);
 	test.simulate();
 	double end_time = CycleTimer::currentSeconds();
 	printf("Total Simulation Time in Secs: %f\n", end_time-start_time);
 
+	// stats are written either way, a deadlocked run only covers the messages that were delivered
+	if (test.has_deadlocked()) return 2;
 	return 0;
 }
 
@@ -2,6 +2,8 @@ import subprocess
 import os
 import sys
 
+from stats_exporter import export_text_stats
+
 if __name__ == "__main__":
 	num_threads = sys.argv[1]
 
@@ -24,6 +26,9 @@ if __name__ == "__main__":
 	stderr_file = open(stderr_path, "w+")
 	for test_path in test_path_lst:
 		result = subprocess.run(["./main", "-t", str(num_threads), "-p", test_path + "/"], stderr=subprocess.PIPE)
+		# the simulator only writes stats.bin, the notebooks still read the text stats files, a deadlocked run exits with 2
+		if result.returncode == 0 or result.returncode == 2:
+			export_text_stats(test_path)
 		if result.stderr:
 			stderr_file.write("/".join(test_path.split('/')[-2:]))
 			stderr_file.write("\n")
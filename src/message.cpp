@@ -2,34 +2,45 @@
 #include <signal.h>
 
 #include "message.h"
-#include "packet.h"
 
 extern uint32_t packet_width;
 extern uint32_t num_data_flits_per_packet;
-extern Message_Transmission_Info** global_message_transmission_info;
+extern uint32_t global_clock;
+extern Message_Transmission_Info* global_message_transmission_info;
 
-Message::Message(uint32_t size, uint32_t message_id, uint32_t source, uint32_t dest) {
+Message::Message(uint32_t size, uint32_t message_id, uint32_t source, uint32_t dest, uint32_t release_time, uint32_t dependency_id) {
 	this->size = size;
-	this->num_packets = this->size / packet_width;
-	this->num_flits = (uint32_t)(this->num_packets * (num_data_flits_per_packet + 2));
 	this->source = source;
 	this->dest = dest;
 	this->message_id = message_id;
+	this->release_time = release_time;
+	this->dependency_id = dependency_id;
 
-	global_message_transmission_info[this->message_id]->avg_packet_distance = 0.0;
-	global_message_transmission_info[this->message_id]->latency = 0;
-	global_message_transmission_info[this->message_id]->size = size;
-	global_message_transmission_info[this->message_id]->tx_processor_id = this->source;
-	global_message_transmission_info[this->message_id]->tx_time = -15418;
-	global_message_transmission_info[this->message_id]->rx_processor_id = this->dest;
-	global_message_transmission_info[this->message_id]->rx_time = -15418;
-
-	
-	this->packet_lst = new Packet*[this->num_packets];
-	for (uint32_t i=0; i < this->num_packets; i++) {
-		Packet* new_packet = new Packet(i, this->message_id, this->num_packets, this->source, this->dest);
-		if (new_packet == nullptr) raise(SIGTRAP);
-		this->packet_lst[i] = new_packet;
-	}
+	global_message_transmission_info[this->message_id].avg_packet_distance = 0.0;
+	global_message_transmission_info[this->message_id].latency = 0;
+	global_message_transmission_info[this->message_id].size = size;
+	global_message_transmission_info[this->message_id].tx_processor_id = this->source;
+	global_message_transmission_info[this->message_id].tx_time = -15418;
+	global_message_transmission_info[this->message_id].rx_processor_id = this->dest;
+	global_message_transmission_info[this->message_id].rx_time = -15418;
+	global_message_transmission_info[this->message_id].creation_time = -1;
+	global_message_transmission_info[this->message_id].num_flits_remaining = this->get_num_flits();
+
+	// flits are only built when the source processor injects the message, see Processor::inject_message
+}
+
+// released and not waiting on another message
+bool Message::is_ready () {
+	if (this->release_time > global_clock) return false;
+	if (this->dependency_id == NO_DEPENDENCY) return true;
+	return global_message_transmission_info[this->dependency_id].rx_time >= 0;
+}
+
+uint32_t Message::get_num_packets () {
+	return this->size / packet_width;
+}
+
+uint32_t Message::get_num_flits () {
+	return (uint32_t)(this->get_num_packets() * (num_data_flits_per_packet + 2));
 }
 
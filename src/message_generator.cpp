@@ -1,6 +1,8 @@
 #include <stdlib.h>
+#include <math.h>
 #include <algorithm>
 #include <vector>
+#include <deque>
 #include <map>
 #include <omp.h>
 #include <cassert>
@@ -8,13 +10,20 @@
 
 #include "message_generator.h"
 #include "message.h"
+#include "random_stream.h"
+
+extern Message_Transmission_Info* global_message_transmission_info;
 
 Message_Generator::Message_Generator (uint32_t num_messages,
 					 				  uint32_t num_processors,
 					  				  uint32_t lower_message_size, 
 					  				  uint32_t upper_message_size, 
 					  				  MESSAGE_SIZE_DISTRIBUTION message_size_distribution,
-					  				  MESSAGE_NODE_DISTRIBUTION message_node_distribution) {
+					  				  MESSAGE_NODE_DISTRIBUTION message_node_distribution,
+					  				  MESSAGE_INJECTION_PROCESS message_injection_process,
+					  				  double injection_rate,
+					  				  double hotspot_fraction,
+					  				  std::vector<uint32_t>* hotspot_vec) {
 
 	this->num_messages = num_messages;
 	this->num_processors = num_processors;
@@ -22,10 +31,21 @@ Message_Generator::Message_Generator (uint32_t num_messages,
 	this->upper_message_size = upper_message_size;
 	this->message_size_distribution = message_size_distribution;
 	this->message_node_distribution = message_node_distribution;
+	this->message_injection_process = message_injection_process;
+	this->injection_rate = injection_rate;
+	this->hotspot_fraction = hotspot_fraction;
+	this->hotspot_vec = hotspot_vec;
 	this->num_messages_tx_by_processor = new uint32_t[this->num_processors];
 	this->num_messages_rx_by_processor = new uint32_t[this->num_processors];
 	this->message_size_lst = new uint32_t[this->num_messages];
 
+	// each message draws from its own epoch, so the result does not depend on loop scheduling
+	this->size_random_stream = new Random_Stream(GENERATOR_STREAM, 0);
+	this->node_random_stream = new Random_Stream(GENERATOR_STREAM, 1);
+	this->shuffle_random_stream = new Random_Stream(GENERATOR_STREAM, 2);
+	this->injection_random_stream = new Random_Stream(GENERATOR_STREAM, 3);
+	this->pattern_random_stream = new Random_Stream(GENERATOR_STREAM, 4);
+
 	// initialize locks
 	this->tx_message_data_map_locks = new omp_lock_t[this->num_processors];
 	this->rx_message_data_map_locks = new omp_lock_t[this->num_processors];
@@ -34,14 +54,11 @@ Message_Generator::Message_Generator (uint32_t num_messages,
         omp_init_lock(&(this->tx_message_data_map_locks[i]));
     }
 
-	// initialize maps
-	this->processor_id_to_tx_message_data_map = new std::map<uint32_t, std::vector<Message*>*>;
-	this->processor_id_to_rx_message_data_map = new std::map<uint32_t, std::map<uint32_t, int>*>;
+	// initialize queues, the dest side only needs the flit count kept in the global message transmission info
+	this->processor_id_to_tx_message_queue_map = new std::map<uint32_t, std::deque<Message>*>;
 	for (uint32_t i=0; i < this->num_processors; i++) {
-		std::vector<Message*>* tx_message_vec = new std::vector<Message*>;
-		this->processor_id_to_tx_message_data_map->insert({i, tx_message_vec});
-		std::map<uint32_t, int>* rx_message_map = new std::map<uint32_t, int>;
-		this->processor_id_to_rx_message_data_map->insert({i, rx_message_map});
+		std::deque<Message>* tx_message_queue = new std::deque<Message>;
+		this->processor_id_to_tx_message_queue_map->insert({i, tx_message_queue});
 	}
 
 	// create message sizes
@@ -63,32 +80,73 @@ Message_Generator::Message_Generator (uint32_t num_messages,
     else if (message_node_distribution == NODE_UNIFORM) {
     	uniform_message_node_distribution_generator();
     }
+    else if (message_node_distribution == NODE_TRANSPOSE) {
+    	pattern_message_node_distribution_generator(&transpose_traffic_pattern);
+    }
+    else if (message_node_distribution == NODE_BIT_COMPLEMENT) {
+    	pattern_message_node_distribution_generator(&bit_complement_traffic_pattern);
+    }
+    else if (message_node_distribution == NODE_BIT_REVERSE) {
+    	pattern_message_node_distribution_generator(&bit_reverse_traffic_pattern);
+    }
+    else if (message_node_distribution == NODE_SHUFFLE) {
+    	pattern_message_node_distribution_generator(&shuffle_traffic_pattern);
+    }
+    else if (message_node_distribution == NODE_TORNADO) {
+    	pattern_message_node_distribution_generator(&tornado_traffic_pattern);
+    }
+    else if (message_node_distribution == NODE_NEIGHBOR) {
+    	pattern_message_node_distribution_generator(&neighbor_traffic_pattern);
+    }
+    else if (message_node_distribution == NODE_HOTSPOT) {
+    	pattern_message_node_distribution_generator(&hotspot_traffic_pattern);
+    }
     else {
     	raise(SIGTRAP);
     	assert(false);
     }
+
+    // spread releases out over time, batch messages are all available from the start
+    if (message_injection_process != INJECTION_BATCH) {
+    	assert(injection_rate > 0.0);
+    	open_loop_message_release_generator();
+    }
 }
 
-void Message_Generator::update_tx_rx_data (Message* message) {
-	uint32_t source_processor_id = message->source;
-	uint32_t dest_processor_id = message->dest;
-	uint32_t num_flits = message->num_flits;
+// the tx message queues are not freed here, they belong to the processors they were handed to
+Message_Generator::~Message_Generator () {
+	for (uint32_t i=0; i < this->num_processors; i++) {
+		omp_destroy_lock(&(this->tx_message_data_map_locks[i]));
+		omp_destroy_lock(&(this->rx_message_data_map_locks[i]));
+	}
+	delete[] this->tx_message_data_map_locks;
+	delete[] this->rx_message_data_map_locks;
+	delete this->processor_id_to_tx_message_queue_map;
+	delete[] this->message_size_lst;
+	delete[] this->num_messages_tx_by_processor;
+	delete[] this->num_messages_rx_by_processor;
+	delete this->size_random_stream;
+	delete this->node_random_stream;
+	delete this->shuffle_random_stream;
+	delete this->injection_random_stream;
+	delete this->pattern_random_stream;
+	delete this->hotspot_vec;
+}
 
-	// add message to tx_data_message_map
-	auto itr_tx = this->processor_id_to_tx_message_data_map->find(source_processor_id);
-	std::vector<Message*>* tx_message_vec = itr_tx->second;
+void Message_Generator::update_tx_rx_data (Message message) {
+	uint32_t source_processor_id = message.source;
+	uint32_t dest_processor_id = message.dest;
+
+	// add message to the source processor's queue
+	auto itr_tx = this->processor_id_to_tx_message_queue_map->find(source_processor_id);
+	std::deque<Message>* tx_message_queue = itr_tx->second;
 
 	omp_set_lock(&(this->tx_message_data_map_locks[source_processor_id]));
-	tx_message_vec->push_back(message);
+	tx_message_queue->push_back(message);
 	this->num_messages_tx_by_processor[source_processor_id] += 1;
 	omp_unset_lock(&(this->tx_message_data_map_locks[source_processor_id]));
 
-	// increment flit count in rx_data_message_map
-	auto itr_rx = this->processor_id_to_rx_message_data_map->find(dest_processor_id);
-	std::map<uint32_t, int>* rx_message_map = itr_rx->second;
-
 	omp_set_lock(&(this->rx_message_data_map_locks[dest_processor_id]));
-	rx_message_map->insert({message->message_id, num_flits});
 	this->num_messages_rx_by_processor[dest_processor_id] += 1;
 	omp_unset_lock(&(this->rx_message_data_map_locks[dest_processor_id]));
 }
@@ -98,7 +156,8 @@ void Message_Generator::random_message_size_distribution_generator () {
 
     #pragma omp for schedule(static)
     for (uint32_t i=0; i < this->num_messages; i++) {
-    	this->message_size_lst[i] = (rand() % message_size_range) + this->lower_message_size;
+    	this->size_random_stream->seek(i);
+    	this->message_size_lst[i] = this->size_random_stream->next_below(message_size_range) + this->lower_message_size;
     }
 }
 
@@ -115,16 +174,16 @@ void Message_Generator::random_message_node_distribution_generator () {
 	#pragma omp for schedule(static)
 	for (uint32_t i=0; i < this->num_messages; i++) {
 		uint32_t message_size = this->message_size_lst[i];
-		uint32_t source_processor_id = rand() % this->num_processors;
+		this->node_random_stream->seek(i);
+		uint32_t source_processor_id = this->node_random_stream->next_below(this->num_processors);
 		// ensure dest processor is not same as source processor
 		uint32_t dest_processor_id;
 		do {
-			dest_processor_id = rand() % this->num_processors;
+			dest_processor_id = this->node_random_stream->next_below(this->num_processors);
 		} while(source_processor_id == dest_processor_id);
 
-		// create message
-		Message* message = new Message(message_size, i, source_processor_id, dest_processor_id);
-		this->update_tx_rx_data(message);
+		// create message, all messages are available from the start
+		this->update_tx_rx_data(Message(message_size, i, source_processor_id, dest_processor_id, 0, NO_DEPENDENCY));
 	}
 }
 
@@ -137,7 +196,7 @@ void Message_Generator::uniform_message_node_distribution_generator () {
 		dest_processor_id_vec.push_back(dest_processor_id);
 	}
 	// shuffle vector so no trivial message distribution across nodes
-	random_shuffle(dest_processor_id_vec.begin(), dest_processor_id_vec.end());
+	this->shuffle_random_stream->shuffle(&dest_processor_id_vec);
 
 	#pragma omp for schedule(static)
 	for (uint32_t i=0; i < this->num_messages; i++) {
@@ -146,24 +205,93 @@ void Message_Generator::uniform_message_node_distribution_generator () {
 		uint32_t dest_processor_id = dest_processor_id_vec[i];
 		// if dest processor id is same as source processor id, just randomly pick a new dest
 		if (source_processor_id == dest_processor_id) {
+			this->node_random_stream->seek(i);
 			do {
-				dest_processor_id = rand() % this->num_processors;
+				dest_processor_id = this->node_random_stream->next_below(this->num_processors);
 			} while(source_processor_id == dest_processor_id);
 		}
 
-		// create message
-		Message* message = new Message(message_size, i, source_processor_id, dest_processor_id);
-		this->update_tx_rx_data(message);
+		// create message, all messages are available from the start
+		this->update_tx_rx_data(Message(message_size, i, source_processor_id, dest_processor_id, 0, NO_DEPENDENCY));
 	}
 }
 
-std::vector<Message*>* Message_Generator::get_tx_message_data_vec (uint32_t processor_id) {
-	auto itr = this->processor_id_to_tx_message_data_map->find(processor_id);
-	return itr->second;
+// sources take turns like the uniform distribution, and the pattern computes all destinations in one pass
+void Message_Generator::pattern_message_node_distribution_generator (Traffic_Pattern_Func traffic_pattern_func) {
+	uint32_t* source_lst = new uint32_t[this->num_messages];
+	uint32_t* dest_lst = new uint32_t[this->num_messages];
+	uint32_t* draw_lst = new uint32_t[2*this->num_messages];
+	for (uint32_t i=0; i < this->num_messages; i++) {
+		source_lst[i] = i % this->num_processors;
+		this->pattern_random_stream->seek(i);
+		draw_lst[2*i] = this->pattern_random_stream->next();
+		draw_lst[2*i+1] = this->pattern_random_stream->next();
+	}
+
+	Traffic_Pattern_Info traffic_pattern_info;
+	traffic_pattern_info.num_processors = this->num_processors;
+	traffic_pattern_info.num_cols = (uint32_t)sqrt(this->num_processors);
+	traffic_pattern_info.num_bits = 0;
+	while ((1u << traffic_pattern_info.num_bits) < this->num_processors) traffic_pattern_info.num_bits++;
+	traffic_pattern_info.draw_lst = draw_lst;
+	traffic_pattern_info.num_hotspots = this->hotspot_vec->size();
+	traffic_pattern_info.hotspot_lst = this->hotspot_vec->data();
+	traffic_pattern_info.hotspot_threshold = (uint32_t)(this->hotspot_fraction * 4294967295.0);
+	traffic_pattern_func(source_lst, dest_lst, this->num_messages, &traffic_pattern_info);
+
+	for (uint32_t i=0; i < this->num_messages; i++) {
+		uint32_t message_size = this->message_size_lst[i];
+		uint32_t source_processor_id = source_lst[i];
+		uint32_t dest_processor_id = dest_lst[i];
+		assert(dest_processor_id < this->num_processors);
+		// processors the pattern maps onto themselves send to a random processor instead
+		if (source_processor_id == dest_processor_id) {
+			this->node_random_stream->seek(i);
+			do {
+				dest_processor_id = this->node_random_stream->next_below(this->num_processors);
+			} while(source_processor_id == dest_processor_id);
+		}
+
+		// create message, all messages are available from the start
+		this->update_tx_rx_data(Message(message_size, i, source_processor_id, dest_processor_id, 0, NO_DEPENDENCY));
+	}
+
+	delete[] source_lst;
+	delete[] dest_lst;
+	delete[] draw_lst;
+}
+
+// each processor creates its messages independently at injection_rate, a message waits in the source queue
+// from its creation until the processor gets to inject it, so latency includes source queueing
+void Message_Generator::open_loop_message_release_generator () {
+	for (uint32_t i=0; i < this->num_processors; i++) {
+		std::deque<Message>* tx_message_queue = this->get_tx_message_queue(i);
+		this->injection_random_stream->seek(i);
+		uint32_t next_free_time = 0;
+		double arrival_time = 0.0;
+		for (auto itr=tx_message_queue->begin(); itr != tx_message_queue->end(); itr++) {
+			double unit = this->injection_random_stream->next_unit();
+			uint32_t release_time;
+			// at most one message per cycle, created with probability injection_rate, so the gap is geometric
+			if (this->message_injection_process == INJECTION_BERNOULLI) {
+				uint32_t gap = 0;
+				if (this->injection_rate < 1.0) gap = (uint32_t)floor(log(1.0 - unit) / log(1.0 - this->injection_rate));
+				release_time = next_free_time + gap;
+				next_free_time = release_time + 1;
+			}
+			// exponential inter-arrival times, several messages may be created in the same cycle
+			else {
+				arrival_time += -log(1.0 - unit) / this->injection_rate;
+				release_time = (uint32_t)arrival_time;
+			}
+			itr->release_time = release_time;
+			global_message_transmission_info[itr->message_id].creation_time = (int)release_time;
+		}
+	}
 }
 
-std::map<uint32_t, int>* Message_Generator::get_rx_message_data_map (uint32_t processor_id) {
-	auto itr = this->processor_id_to_rx_message_data_map->find(processor_id);
+std::deque<Message>* Message_Generator::get_tx_message_queue (uint32_t processor_id) {
+	auto itr = this->processor_id_to_tx_message_queue_map->find(processor_id);
 	return itr->second;
 }
 
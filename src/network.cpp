@@ -3,15 +3,84 @@
 #include <vector>
 #include <omp.h>
 #include <signal.h>
+#include <cassert>
 
 #include "network.h"
 #include "flow_control_algorithms.h"
 #include "routing_algorithms.h"
 #include "node.h"
 #include "channel.h"
+#include "heatmap_writer.h"
+
+extern uint32_t global_channel_id;
+extern uint32_t global_clock;
 
 NETWORK_TYPE network_type;
 void* network_info;
+Active_Set* global_active_set = NULL;
+
+Active_Set::Active_Set (uint32_t num_threads) {
+	this->num_threads = num_threads;
+	this->scheduled_node_vecs = new std::vector<Node*>*[this->num_threads];
+	for (uint32_t i=0; i < this->num_threads; i++) {
+		this->scheduled_node_vecs[i] = new std::vector<Node*>;
+	}
+	this->router_vec = new std::vector<Router*>;
+	this->processor_vec = new std::vector<Processor*>;
+}
+
+// called from inside parallel regions, so every thread appends to its own vector
+void Active_Set::insert (Node* node) {
+	uint32_t thread_id = omp_get_thread_num();
+	this->scheduled_node_vecs[thread_id]->push_back(node);
+}
+
+void Active_Set::merge_scheduled_nodes () {
+	for (uint32_t i=0; i < this->num_threads; i++) {
+		std::vector<Node*>* scheduled_node_vec = this->scheduled_node_vecs[i];
+		for (auto itr=scheduled_node_vec->begin(); itr != scheduled_node_vec->end(); itr++) {
+			Node* node = *itr;
+			if (node->type == PROCESSOR) this->processor_vec->push_back((Processor*)node);
+			else this->router_vec->push_back((Router*)node);
+		}
+		scheduled_node_vec->clear();
+	}
+}
+
+void Active_Set::retire_idle_nodes () {
+	uint32_t num_active_routers = 0;
+	for (uint32_t i=0; i < this->router_vec->size(); i++) {
+		Router* router = (*this->router_vec)[i];
+		if (router->has_pending_work()) {
+			(*this->router_vec)[num_active_routers++] = router;
+		}
+		else {
+			// leave the router without stalls since it is skipped until it is scheduled again
+			router->clear_internal_info_summary();
+			router->update_internal_info_summary();
+			router->unschedule();
+		}
+	}
+	this->router_vec->resize(num_active_routers);
+
+	uint32_t num_active_processors = 0;
+	for (uint32_t i=0; i < this->processor_vec->size(); i++) {
+		Processor* processor = (*this->processor_vec)[i];
+		if (processor->has_pending_work()) {
+			(*this->processor_vec)[num_active_processors++] = processor;
+		}
+		else {
+			processor->unschedule();
+		}
+	}
+	this->processor_vec->resize(num_active_processors);
+}
+
+void Active_Set::clear () {
+	for (uint32_t i=0; i < this->num_threads; i++) this->scheduled_node_vecs[i]->clear();
+	this->router_vec->clear();
+	this->processor_vec->clear();
+}
 
 Network::Network (uint32_t num_processors, 
 				  uint32_t num_routers, 
@@ -26,6 +95,11 @@ Network::Network (uint32_t num_processors,
 	this->num_virtual_channels = num_virtual_channels;
 	this->processor_lst = new Processor*[this->num_processors];
 	this->router_lst = new Router*[this->num_routers];
+	this->engine = FULL_SWEEP;
+	this->active_set = NULL;
+	this->num_partitions = 0;
+	this->partition_router_vecs = NULL;
+	this->partition_processor_vecs = NULL;
 }
 
 void Network::init_connection (Node* node_A, Node* node_B) {
@@ -39,9 +113,59 @@ void Network::init_connection (Node* node_A, Node* node_B) {
 	node_B->init_connection(node_A, channel_A_B, channel_B_A);
 }
 
+// clears everything a run leaves behind so the next one starts on a network that looks freshly built
+void Network::reset () {
+	for (uint32_t i=0; i < this->num_routers; i++) this->router_lst[i]->reset();
+	for (uint32_t i=0; i < this->num_processors; i++) this->processor_lst[i]->reset();
+	Flit_Pool::reset_packet_chunks();
+	if (this->active_set != NULL) this->active_set->clear();
+}
+
+// a reset network keeps its active set and partitions, the engine cannot change between runs
+void Network::init_simulation_engine (SIMULATION_ENGINE engine) {
+	assert(this->active_set == NULL || engine == this->engine);
+	this->engine = engine;
+
+	if (this->engine == ACTIVE_SET) {
+		if (this->active_set == NULL) this->active_set = new Active_Set(omp_get_max_threads());
+		global_active_set = this->active_set;
+
+		// at the start only processors with messages to send have work to do
+		for (uint32_t i=0; i < this->num_processors; i++) {
+			Processor* processor = this->processor_lst[i];
+			if (processor->has_pending_work()) processor->schedule();
+		}
+	}
+	else if (this->engine == WORKER_POOL) {
+		if (this->partition_router_vecs == NULL) this->init_partitions(omp_get_max_threads());
+	}
+}
 
+// contiguous blocks of routers and processors, the same split as schedule(static)
+void Network::init_partitions (uint32_t num_partitions) {
+	this->num_partitions = num_partitions;
+	this->partition_router_vecs = new std::vector<Router*>*[this->num_partitions];
+	this->partition_processor_vecs = new std::vector<Processor*>*[this->num_partitions];
+	for (uint32_t i=0; i < this->num_partitions; i++) {
+		this->partition_router_vecs[i] = new std::vector<Router*>;
+		this->partition_processor_vecs[i] = new std::vector<Processor*>;
+	}
+	for (uint32_t i=0; i < this->num_routers; i++) {
+		uint32_t partition_id = ((uint64_t)i * this->num_partitions) / this->num_routers;
+		this->partition_router_vecs[partition_id]->push_back(this->router_lst[i]);
+	}
+	for (uint32_t i=0; i < this->num_processors; i++) {
+		uint32_t partition_id = ((uint64_t)i * this->num_partitions) / this->num_processors;
+		this->partition_processor_vecs[partition_id]->push_back(this->processor_lst[i]);
+	}
+}
 
 void Network::simulate () {
+	if (this->engine == ACTIVE_SET) this->simulate_active_set();
+	else this->simulate_full_sweep();
+}
+
+void Network::simulate_full_sweep () {
 	#pragma omp parallel 
 	{
 		#pragma omp for schedule(static) nowait
@@ -67,7 +191,8 @@ void Network::simulate () {
 			Router* router = this->router_lst[i];
 			router->rx();
 		}
-		#pragma omp for schedule(static) nowait
+		// routers may still be pulling flits out of each others buffers, so wait before summarizing
+		#pragma omp for schedule(static)
 		for (uint32_t i=0; i < this->num_processors; i++) {
 			Processor* processor = this->processor_lst[i];
 			processor->rx();
@@ -81,6 +206,125 @@ void Network::simulate () {
 	}
 }
 
+// same phases as simulate_full_sweep, but only over routers and processors in the active set
+void Network::simulate_active_set () {
+	Active_Set* active_set = this->active_set;
+
+	// drop nodes that went idle last cycle and pick up nodes scheduled since then
+	active_set->retire_idle_nodes();
+	active_set->merge_scheduled_nodes();
+
+	std::vector<Router*>* router_vec = active_set->router_vec;
+	std::vector<Processor*>* processor_vec = active_set->processor_vec;
+	uint32_t num_tx_routers = router_vec->size();
+	uint32_t num_tx_processors = processor_vec->size();
+
+	#pragma omp parallel 
+	{
+		#pragma omp for schedule(static) nowait
+		for (uint32_t i=0; i < num_tx_routers; i++) {
+			Router* router = (*router_vec)[i];
+			router->clear_internal_info_summary();
+		}
+		#pragma omp for schedule(static) nowait
+		for (uint32_t i=0; i < num_tx_processors; i++) {
+			Processor* processor = (*processor_vec)[i];
+			processor->tx();
+		}
+		#pragma omp for schedule(static) nowait
+		for (uint32_t i=0; i < num_tx_routers; i++) {
+			Router* router = (*router_vec)[i];
+			router->tx();
+		}
+	}
+
+	// idle nodes that were proposed a flit during tx have to pull it in during rx
+	active_set->merge_scheduled_nodes();
+	uint32_t num_rx_routers = router_vec->size();
+	uint32_t num_rx_processors = processor_vec->size();
+
+	#pragma omp parallel 
+	{
+		#pragma omp for schedule(static)
+		for (uint32_t i=num_tx_routers; i < num_rx_routers; i++) {
+			Router* router = (*router_vec)[i];
+			router->clear_internal_info_summary();
+		}
+		#pragma omp for schedule(static) nowait
+		for (uint32_t i=0; i < num_rx_routers; i++) {
+			Router* router = (*router_vec)[i];
+			router->rx();
+		}
+		#pragma omp for schedule(static)
+		for (uint32_t i=0; i < num_rx_processors; i++) {
+			Processor* processor = (*processor_vec)[i];
+			processor->rx();
+		}
+
+		#pragma omp for schedule(static) nowait
+		for (uint32_t i=0; i < num_rx_routers; i++) {
+			Router* router = (*router_vec)[i];
+			router->update_internal_info_summary();
+		}
+	}
+}
+
+// the phases of simulate_full_sweep split by partition, the caller has to sync between them
+void Network::tx_partition (uint32_t partition_id) {
+	std::vector<Router*>* router_vec = this->partition_router_vecs[partition_id];
+	std::vector<Processor*>* processor_vec = this->partition_processor_vecs[partition_id];
+	for (uint32_t i=0; i < router_vec->size(); i++) {
+		(*router_vec)[i]->clear_internal_info_summary();
+	}
+	for (uint32_t i=0; i < processor_vec->size(); i++) {
+		(*processor_vec)[i]->tx();
+	}
+	for (uint32_t i=0; i < router_vec->size(); i++) {
+		(*router_vec)[i]->tx();
+	}
+}
+
+void Network::rx_partition (uint32_t partition_id) {
+	std::vector<Router*>* router_vec = this->partition_router_vecs[partition_id];
+	std::vector<Processor*>* processor_vec = this->partition_processor_vecs[partition_id];
+	for (uint32_t i=0; i < router_vec->size(); i++) {
+		(*router_vec)[i]->rx();
+	}
+	for (uint32_t i=0; i < processor_vec->size(); i++) {
+		(*processor_vec)[i]->rx();
+	}
+}
+
+// the router summaries are needed every cycle, the over time metrics only when a sample is taken
+void Network::summarize_partition (uint32_t partition_id) {
+	std::vector<Router*>* router_vec = this->partition_router_vecs[partition_id];
+	for (uint32_t i=0; i < router_vec->size(); i++) {
+		(*router_vec)[i]->update_internal_info_summary();
+	}
+}
+
+// sums this partition's share of the over time metrics
+void Network::sum_partition_metrics (uint32_t partition_id, Over_Time_Metrics* metrics) {
+	std::vector<Router*>* router_vec = this->partition_router_vecs[partition_id];
+	std::vector<Processor*>* processor_vec = this->partition_processor_vecs[partition_id];
+	metrics->tx_flits = 0;
+	metrics->rx_flits = 0;
+	metrics->num_stalls = 0;
+	metrics->buffers_space_occupied = 0;
+	metrics->buffers_space_total = 0;
+	for (uint32_t i=0; i < router_vec->size(); i++) {
+		Router* router = (*router_vec)[i];
+		metrics->num_stalls += router->get_total_num_stalls();
+		metrics->buffers_space_occupied += router->get_buffer_space_occupied();
+		metrics->buffers_space_total += router->get_buffer_space_total();
+	}
+	for (uint32_t i=0; i < processor_vec->size(); i++) {
+		Processor* processor = (*processor_vec)[i];
+		metrics->tx_flits += processor->num_flits_transmitted;
+		metrics->rx_flits += processor->num_flits_received;
+	}
+}
+
 
 
 Mesh_Network::Mesh_Network (uint32_t num_processors, 
@@ -90,7 +334,29 @@ Mesh_Network::Mesh_Network (uint32_t num_processors,
 							uint32_t num_virtual_channels,
 							Routing_Func routing_func, 
 							Flow_Control_Func flow_control_func, 
-							FLOW_CONTROL_GRANULARITY flow_control_granularity) : 
+							FLOW_CONTROL_GRANULARITY flow_control_granularity,
+							Worker_Pool* worker_pool) : 
+Mesh_Network(MESH,
+			 num_processors, 
+			 num_routers, 
+			 input_buffer_capacity, 
+			 router_buffer_capacity, 
+			 num_virtual_channels,
+			 routing_func,
+			 flow_control_func,
+			 flow_control_granularity,
+			 worker_pool) {}
+
+Mesh_Network::Mesh_Network (NETWORK_TYPE topology,
+							uint32_t num_processors, 
+							uint32_t num_routers, 
+							uint32_t input_buffer_capacity, 
+							uint32_t router_buffer_capacity, 
+							uint32_t num_virtual_channels,
+							Routing_Func routing_func, 
+							Flow_Control_Func flow_control_func, 
+							FLOW_CONTROL_GRANULARITY flow_control_granularity,
+							Worker_Pool* worker_pool) : 
 Network(num_processors, 
 		num_routers, 
 		input_buffer_capacity, 
@@ -99,71 +365,282 @@ Network(num_processors,
 
 	this->num_rows = sqrt(this->num_processors);
 	this->num_cols = sqrt(this->num_processors);
+	this->has_wraparound = topology == TORUS;
+	this->routing_func = routing_func;
+	this->flow_control_func = flow_control_func;
+	this->flow_control_granularity = flow_control_granularity;
+	assert(!this->has_wraparound || (this->num_rows >= 3 && this->num_cols >= 3));
 
 	// set global vars to identify mesh Network
-	network_type = MESH;
+	network_type = topology;
 	Mesh_Info* mesh_info = new Mesh_Info;
 	mesh_info->num_rows = this->num_rows;
 	mesh_info->num_cols = this->num_cols;
 	network_info = (void*)mesh_info;
 
-	// create NxN array of processors, N = sqrt(num_processors)
+	// NxN arrays of processors and routers, N = sqrt(num_processors)
 	this->processor_mesh = new Processor**[num_rows];
+	this->router_mesh = new Processor_Router**[num_rows];
 	for (uint32_t i=0; i < this->num_rows; i++) {
 		this->processor_mesh[i] = new Processor*[num_cols];
-		for (uint32_t j=0; j < this->num_cols; j++) {
+		this->router_mesh[i] = new Processor_Router*[num_cols];
+	}
+
+	// one processor link per node, plus one east and one south link per router that has that neighbor
+	uint32_t num_links = this->num_processors + this->num_rows*(this->num_cols-1) + (this->num_rows-1)*this->num_cols;
+	if (this->has_wraparound) num_links = 3 * this->num_processors;
+	this->num_channels = 2 * num_links;
+	this->channel_lst = new Channel*[this->num_channels];
+
+	// with a worker pool every thread builds its own tile, so the memory ends up local to the thread that simulates it
+	if (worker_pool != NULL) {
+		this->init_tiles(worker_pool->num_threads);
+		this->build_barrier = worker_pool->barrier;
+		worker_pool->run(&build_mesh_tile_thread, (void*)this);
+	}
+	else {
+		this->init_tiles(1);
+		this->build_barrier = NULL;
+		this->build_tile(0);
+	}
+	global_channel_id = this->num_channels;
+}
+
+void Mesh_Network::build_mesh_tile_thread (uint32_t thread_id, void* arg) {
+	((Mesh_Network*)arg)->build_tile(thread_id);
+}
+
+// split the mesh into tile_rows x tile_cols rectangles, picking the split with the fewest cut links
+void Mesh_Network::init_tiles (uint32_t num_tiles) {
+	uint32_t best_tile_rows = 1;
+	uint32_t best_num_cut_links = (uint32_t)-1;
+	bool best_is_valid = false;
+	for (uint32_t tile_rows=1; tile_rows <= num_tiles; tile_rows++) {
+		if (num_tiles % tile_rows != 0) continue;
+		uint32_t tile_cols = num_tiles / tile_rows;
+		// more tiles than rows or columns leaves some tiles empty, only pick that if nothing else fits
+		bool is_valid = tile_rows <= this->num_rows && tile_cols <= this->num_cols;
+		uint32_t num_cut_links = (tile_rows-1)*this->num_cols + (tile_cols-1)*this->num_rows;
+		if ((is_valid && !best_is_valid) || (is_valid == best_is_valid && num_cut_links < best_num_cut_links)) {
+			best_tile_rows = tile_rows;
+			best_num_cut_links = num_cut_links;
+			best_is_valid = is_valid;
+		}
+	}
+	this->num_tiles = num_tiles;
+	this->num_tile_rows = best_tile_rows;
+	this->num_tile_cols = num_tiles / best_tile_rows;
+}
+
+void Mesh_Network::get_tile_bounds (uint32_t tile_id, uint32_t* row_begin, uint32_t* row_end, uint32_t* col_begin, uint32_t* col_end) {
+	uint32_t tile_row = tile_id / this->num_tile_cols;
+	uint32_t tile_col = tile_id % this->num_tile_cols;
+	*row_begin = (tile_row * this->num_rows) / this->num_tile_rows;
+	*row_end = ((tile_row+1) * this->num_rows) / this->num_tile_rows;
+	*col_begin = (tile_col * this->num_cols) / this->num_tile_cols;
+	*col_end = ((tile_col+1) * this->num_cols) / this->num_tile_cols;
+}
+
+// id of the processor to router channel at (row, col), the router to processor channel is the next id
+uint32_t Mesh_Network::get_processor_channel_id (uint32_t row, uint32_t col) {
+	return 2 * (row*this->num_cols + col);
+}
+
+// id of the channel from (row, col) to its east or south neighbor, the channel back is the next id
+uint32_t Mesh_Network::get_router_channel_id (uint32_t row, uint32_t col, bool is_south) {
+	// every torus router has both links
+	if (this->has_wraparound) return 2 * (this->num_processors + 2*(row*this->num_cols + col) + is_south);
+
+	uint32_t num_links_per_row = 2*this->num_cols - 1;
+	uint32_t num_links_per_node = (row < this->num_rows-1) ? 2 : 1;
+	uint32_t link_id = row*num_links_per_row + col*num_links_per_node;
+	if (is_south && col < this->num_cols-1) link_id++;
+	return 2 * (this->num_processors + link_id);
+}
+
+// the router next to (row, col) through the given port, false on the edge of a mesh
+bool Mesh_Network::get_neighbor (uint32_t row, uint32_t col, MESH_PORT port, uint32_t* neighbor_row, uint32_t* neighbor_col) {
+	*neighbor_row = row;
+	*neighbor_col = col;
+	switch (port) {
+		case NORTH_PORT:
+			if (row == 0 && !this->has_wraparound) return false;
+			*neighbor_row = (row + this->num_rows - 1) % this->num_rows;
+			return true;
+		case EAST_PORT:
+			if (col == this->num_cols-1 && !this->has_wraparound) return false;
+			*neighbor_col = (col + 1) % this->num_cols;
+			return true;
+		case SOUTH_PORT:
+			if (row == this->num_rows-1 && !this->has_wraparound) return false;
+			*neighbor_row = (row + 1) % this->num_rows;
+			return true;
+		case WEST_PORT:
+			if (col == 0 && !this->has_wraparound) return false;
+			*neighbor_col = (col + this->num_cols - 1) % this->num_cols;
+			return true;
+		// should never come here
+		default: assert(false);
+	}
+	return false;
+}
+
+// builds one tile in three steps: nodes, then the channels into them, then the connections
+void Mesh_Network::build_tile (uint32_t tile_id) {
+	uint32_t row_begin, row_end, col_begin, col_end;
+	this->get_tile_bounds(tile_id, &row_begin, &row_end, &col_begin, &col_end);
+
+	for (uint32_t i=row_begin; i < row_end; i++) {
+		for (uint32_t j=col_begin; j < col_end; j++) {
 			Mesh_ID* mesh_id = new Mesh_ID;
 			mesh_id->x = j;
 			mesh_id->y = i;
 			Processor* new_processor = new Processor(i*num_cols + j, (void*)mesh_id, 1, 1, this->input_buffer_capacity);
 			this->processor_mesh[i][j] = new_processor;
 			this->processor_lst[i*num_cols + j] = new_processor;
-		}
-	}
 
-	// create NxN array of routers, N = sqrt(num_routers)
-	this->router_mesh = new Processor_Router**[num_rows];
-	for (uint32_t i=0; i < this->num_rows; i++) {
-		this->router_mesh[i] = new Processor_Router*[num_cols];
-		for (uint32_t j=0; j < this->num_cols; j++) {
-			Mesh_ID* mesh_id = new Mesh_ID;
+			// one input channel from the processor and one from each mesh neighbor
+			uint32_t num_neighbors = 0;
+			for (uint32_t port=NORTH_PORT; port <= WEST_PORT; port++) {
+				uint32_t neighbor_row, neighbor_col;
+				num_neighbors += this->get_neighbor(i, j, (MESH_PORT)port, &neighbor_row, &neighbor_col);
+			}
+			mesh_id = new Mesh_ID;
 			mesh_id->x = j;
 			mesh_id->y = i;
 			Processor_Router* new_processor_router = new Processor_Router(i*num_cols + j, 
 																		  (void*)mesh_id, 
-																		  1, 
-																		  1, 
+																		  num_neighbors + 1, 
+																		  num_neighbors, 
 																		  this->router_buffer_capacity, 
 																		  this->num_virtual_channels,
-																		  routing_func,
-																		  flow_control_func,
-																		  flow_control_granularity);
+																		  this->routing_func,
+																		  this->flow_control_func,
+																		  this->flow_control_granularity);
 			this->router_mesh[i][j] = new_processor_router;
 			this->router_lst[i*num_cols + j] = (Router*)new_processor_router;
 		}
 	}
+	if (this->build_barrier != NULL) this->build_barrier->wait(tile_id);
 
-	// connect processor and router together
-	for (uint32_t i=0; i < this->num_rows; i++) {
-		for (uint32_t j=0; j < this->num_cols; j++) {
-			this->init_connection(this->processor_mesh[i][j], this->router_mesh[i][j]);
+	// every node allocates the channels it receives on, so only links between tiles are shared
+	for (uint32_t i=row_begin; i < row_end; i++) {
+		for (uint32_t j=col_begin; j < col_end; j++) {
+			Processor* processor = this->processor_mesh[i][j];
+			Processor_Router* router = this->router_mesh[i][j];
+			uint32_t processor_channel_id = this->get_processor_channel_id(i, j);
+			this->channel_lst[processor_channel_id] = new Channel(processor, router, processor_channel_id);
+			this->channel_lst[processor_channel_id+1] = new Channel(router, processor, processor_channel_id+1);
+			// channels from the west and north neighbor are the reverse half of that neighbor's east and south link
+			uint32_t neighbor_row, neighbor_col;
+			if (this->get_neighbor(i, j, EAST_PORT, &neighbor_row, &neighbor_col)) {
+				uint32_t east_channel_id = this->get_router_channel_id(i, j, false) + 1;
+				this->channel_lst[east_channel_id] = new Channel(this->router_mesh[neighbor_row][neighbor_col], router, east_channel_id);
+			}
+			if (this->get_neighbor(i, j, SOUTH_PORT, &neighbor_row, &neighbor_col)) {
+				uint32_t south_channel_id = this->get_router_channel_id(i, j, true) + 1;
+				this->channel_lst[south_channel_id] = new Channel(this->router_mesh[neighbor_row][neighbor_col], router, south_channel_id);
+			}
+			if (this->get_neighbor(i, j, WEST_PORT, &neighbor_row, &neighbor_col)) {
+				uint32_t west_channel_id = this->get_router_channel_id(neighbor_row, neighbor_col, false);
+				this->channel_lst[west_channel_id] = new Channel(this->router_mesh[neighbor_row][neighbor_col], router, west_channel_id);
+			}
+			if (this->get_neighbor(i, j, NORTH_PORT, &neighbor_row, &neighbor_col)) {
+				uint32_t north_channel_id = this->get_router_channel_id(neighbor_row, neighbor_col, true);
+				this->channel_lst[north_channel_id] = new Channel(this->router_mesh[neighbor_row][neighbor_col], router, north_channel_id);
+			}
 		}
 	}
+	if (this->build_barrier != NULL) this->build_barrier->wait(tile_id);
 
-	// connect routers together
+	// connect processor and router together, then each router to its neighbors
+	for (uint32_t i=row_begin; i < row_end; i++) {
+		for (uint32_t j=col_begin; j < col_end; j++) {
+			Processor* processor = this->processor_mesh[i][j];
+			Processor_Router* router = this->router_mesh[i][j];
+			uint32_t processor_channel_id = this->get_processor_channel_id(i, j);
+			Channel* channel_P_R = this->channel_lst[processor_channel_id];
+			Channel* channel_R_P = this->channel_lst[processor_channel_id+1];
+			processor->init_connection(router, channel_R_P, channel_P_R);
+			router->init_connection(processor, channel_P_R, channel_R_P);
+			uint32_t neighbor_row, neighbor_col;
+			if (this->get_neighbor(i, j, EAST_PORT, &neighbor_row, &neighbor_col)) {
+				uint32_t east_channel_id = this->get_router_channel_id(i, j, false);
+				router->init_connection(this->router_mesh[neighbor_row][neighbor_col], this->channel_lst[east_channel_id+1], this->channel_lst[east_channel_id]);
+			}
+			if (this->get_neighbor(i, j, SOUTH_PORT, &neighbor_row, &neighbor_col)) {
+				uint32_t south_channel_id = this->get_router_channel_id(i, j, true);
+				router->init_connection(this->router_mesh[neighbor_row][neighbor_col], this->channel_lst[south_channel_id+1], this->channel_lst[south_channel_id]);
+			}
+			if (this->get_neighbor(i, j, WEST_PORT, &neighbor_row, &neighbor_col)) {
+				uint32_t west_channel_id = this->get_router_channel_id(neighbor_row, neighbor_col, false);
+				router->init_connection(this->router_mesh[neighbor_row][neighbor_col], this->channel_lst[west_channel_id], this->channel_lst[west_channel_id+1]);
+			}
+			if (this->get_neighbor(i, j, NORTH_PORT, &neighbor_row, &neighbor_col)) {
+				uint32_t north_channel_id = this->get_router_channel_id(neighbor_row, neighbor_col, true);
+				router->init_connection(this->router_mesh[neighbor_row][neighbor_col], this->channel_lst[north_channel_id], this->channel_lst[north_channel_id+1]);
+			}
+		}
+	}
+}
+
+// one partition per tile, so most channels a thread touches stay inside its own tile
+void Mesh_Network::init_partitions (uint32_t num_partitions) {
+	if (this->num_tiles != num_partitions) this->init_tiles(num_partitions);
+
+	this->num_partitions = num_partitions;
+	this->partition_router_vecs = new std::vector<Router*>*[this->num_partitions];
+	this->partition_processor_vecs = new std::vector<Processor*>*[this->num_partitions];
+	for (uint32_t tile_id=0; tile_id < this->num_partitions; tile_id++) {
+		this->partition_router_vecs[tile_id] = new std::vector<Router*>;
+		this->partition_processor_vecs[tile_id] = new std::vector<Processor*>;
+		uint32_t row_begin, row_end, col_begin, col_end;
+		this->get_tile_bounds(tile_id, &row_begin, &row_end, &col_begin, &col_end);
+		for (uint32_t i=row_begin; i < row_end; i++) {
+			for (uint32_t j=col_begin; j < col_end; j++) {
+				this->partition_router_vecs[tile_id]->push_back((Router*)this->router_mesh[i][j]);
+				this->partition_processor_vecs[tile_id]->push_back(this->processor_mesh[i][j]);
+			}
+		}
+	}
+}
+
+// channel into the router at (row, col) through the given port, NULL on the edge of the mesh
+Channel* Mesh_Network::get_port_channel (uint32_t row, uint32_t col, MESH_PORT port) {
+	uint32_t neighbor_row, neighbor_col;
+	if (port <= WEST_PORT && !this->get_neighbor(row, col, port, &neighbor_row, &neighbor_col)) return NULL;
+	switch (port) {
+		case NORTH_PORT: return this->channel_lst[this->get_router_channel_id(neighbor_row, neighbor_col, true)];
+		case EAST_PORT: return this->channel_lst[this->get_router_channel_id(row, col, false) + 1];
+		case SOUTH_PORT: return this->channel_lst[this->get_router_channel_id(row, col, true) + 1];
+		case WEST_PORT: return this->channel_lst[this->get_router_channel_id(neighbor_row, neighbor_col, false)];
+		case INJECTION_PORT: return this->channel_lst[this->get_processor_channel_id(row, col)];
+		case EJECTION_PORT: return this->channel_lst[this->get_processor_channel_id(row, col) + 1];
+		// should never come here
+		default: assert(false);
+	}
+	return NULL;
+}
+
+Heatmap_Writer* Mesh_Network::create_heatmap_writer (std::string heatmap_file_path) {
+	return new Heatmap_Writer(heatmap_file_path, this->num_rows, this->num_cols, NUM_MESH_PORTS, this->num_virtual_channels);
+}
+
+// called between cycles, so the counters are not being written while they are read
+void Mesh_Network::write_heatmap_snapshot (Heatmap_Writer* heatmap_writer) {
+	heatmap_writer->begin_snapshot(global_clock);
 	for (uint32_t i=0; i < this->num_rows; i++) {
 		for (uint32_t j=0; j < this->num_cols; j++) {
-			Processor_Router* curr_router = this->router_mesh[i][j];
-			if (j < num_cols-1) {
-				// connect east
-				this->init_connection(curr_router, this->router_mesh[i][j+1]);
-			}
-			if (i < num_rows - 1) {
-				// conect south
-				this->init_connection(curr_router, this->router_mesh[i+1][j]);
+			Processor_Router* router = this->router_mesh[i][j];
+			for (uint32_t port=0; port < NUM_MESH_PORTS; port++) {
+				Channel* channel = this->get_port_channel(i, j, (MESH_PORT)port);
+				// the ejection channel ends in the processor, which has no virtual channels
+				if (channel == NULL || port == EJECTION_PORT) heatmap_writer->append_port(channel, NULL, 0);
+				else heatmap_writer->append_port(channel, router->input_channel_to_buffers_map->at(channel), this->num_virtual_channels);
 			}
 		}
 	}
+	heatmap_writer->end_snapshot();
 }
 
 void Mesh_Network::print() {
@@ -191,4 +668,24 @@ void Mesh_Network::print() {
 	printf("==================================================\n");
 	printf("==================================================\n");
 	printf("\n");
-}
\ No newline at end of file
+}
+
+Torus_Network::Torus_Network (uint32_t num_processors, 
+							  uint32_t num_routers, 
+							  uint32_t input_buffer_capacity, 
+							  uint32_t router_buffer_capacity, 
+							  uint32_t num_virtual_channels,
+							  Routing_Func routing_func, 
+							  Flow_Control_Func flow_control_func, 
+							  FLOW_CONTROL_GRANULARITY flow_control_granularity,
+							  Worker_Pool* worker_pool) : 
+Mesh_Network(TORUS,
+			 num_processors, 
+			 num_routers, 
+			 input_buffer_capacity, 
+			 router_buffer_capacity, 
+			 num_virtual_channels,
+			 routing_func,
+			 flow_control_func,
+			 flow_control_granularity,
+			 worker_pool) {}
@@ -10,111 +10,40 @@
 #include <algorithm>
 
 #include "routing_algorithms.h"
+#include "network.h"
 #include "node.h"
 #include "channel.h"
 #include "buffer.h"
 #include "message.h"
+#include "completion_tracker.h"
+#include "latency_histogram.h"
 
 extern uint32_t num_data_flits_per_packet;
 extern uint32_t global_clock;
-extern Message_Transmission_Info** global_message_transmission_info;
-
-Flit_Info_To_Router_ID_Cache::Flit_Info_To_Router_ID_Cache () {
-	this->flit_info_to_router_id_map = new std::map<Flit_Info*, uint32_t, flit_info_comp>;
-	omp_init_lock(&this->lock);
-}
-
-void Flit_Info_To_Router_ID_Cache::insert (Flit_Info* flit_info, uint32_t next_dest_router_id) {
-	omp_set_lock(&this->lock);
-	this->flit_info_to_router_id_map->insert({flit_info, next_dest_router_id});
-	omp_unset_lock(&this->lock);
-}
-
-void Flit_Info_To_Router_ID_Cache::erase (Flit_Info* flit_info) {
-	omp_set_lock(&this->lock);
-	auto itr = this->flit_info_to_router_id_map->find(flit_info);
-	assert(itr != this->flit_info_to_router_id_map->end());
-	delete(itr->first);
-	this->flit_info_to_router_id_map->erase(itr);
-	omp_unset_lock(&this->lock);
-}
-
-uint32_t Flit_Info_To_Router_ID_Cache::find (Flit_Info* flit_info) {
-	auto itr = this->flit_info_to_router_id_map->find(flit_info);
-	assert(itr != this->flit_info_to_router_id_map->end());
-	return itr->second; 
-}
-
-bool Flit_Info_To_Router_ID_Cache::is_in (Flit_Info* flit_info) {
-	auto itr = this->flit_info_to_router_id_map->find(flit_info);
-	return itr != this->flit_info_to_router_id_map->end();
-}
+extern Message_Transmission_Info* global_message_transmission_info;
+extern Active_Set* global_active_set;
+extern Completion_Tracker* global_completion_tracker;
 
 Internal_Info_Summary::Internal_Info_Summary () {
-	this->message_id_to_packet_id_set_map = new std::map<uint32_t, std::set<uint32_t>*>;
-	this->buffer_to_flit_info_set_map = new std::map<Buffer*, std::set<Flit_Info*, flit_info_comp>*>;
-	this->buffer_space_occupied = 0;
+	this->buffer_vec = new std::vector<Buffer*>;
 	this->buffer_space_total = 0;
 	this->num_stalls = 0;
+	this->total_num_stalls = 0;
 }
 
-void Internal_Info_Summary::init_buffer_in_map (Buffer* buffer) {
-	std::set<Flit_Info*, flit_info_comp>* flit_info_set = new std::set<Flit_Info*, flit_info_comp>;
-	this->buffer_to_flit_info_set_map->insert({buffer, flit_info_set});
-}
-
-void Internal_Info_Summary::insert (Buffer* buffer, uint32_t message_id, uint32_t packet_id) {
-	auto itr_message = this->message_id_to_packet_id_set_map->find(message_id);
-	// first check if message id is already in map
-	if (itr_message != this->message_id_to_packet_id_set_map->end()) {
-		std::set<uint32_t>* packet_id_set = itr_message->second;
-		// second check if packet is not already in set
-		if (packet_id_set->find(packet_id) == packet_id_set->end()) {
-			packet_id_set->insert(packet_id);
-
-			// add flit info to map so that buffer can keep track of its contents
-			Flit_Info* flit_info = new Flit_Info;
-			flit_info->message_id = message_id;
-			flit_info->packet_id = packet_id;
-			auto itr_buffer = this->buffer_to_flit_info_set_map->find(buffer);
-			assert(itr_buffer != this->buffer_to_flit_info_set_map->end());
-			std::set<Flit_Info*, flit_info_comp>* flit_info_set = itr_buffer->second;
-			flit_info_set->insert(flit_info);
-		}
-		return;
-	}
-
- 	// message id was not in map, so make new entry in map
- 	std::set<uint32_t>* packet_id_set = new std::set<uint32_t>;
- 	packet_id_set->insert(packet_id);
- 	this->message_id_to_packet_id_set_map->insert({message_id, packet_id_set});
-
- 	// message id was not in map, so add to flit info vec
- 	Flit_Info* flit_info = new Flit_Info;
-	flit_info->message_id = message_id;
-	flit_info->packet_id = packet_id;
-	auto itr_buffer = this->buffer_to_flit_info_set_map->find(buffer);
-	assert(itr_buffer != this->buffer_to_flit_info_set_map->end());
-	std::set<Flit_Info*, flit_info_comp>* flit_info_set = itr_buffer->second;
-	flit_info_set->insert(flit_info);
+// buffers are fixed once connected, so the total is known up front
+void Internal_Info_Summary::init_buffer (Buffer* buffer) {
+	this->buffer_vec->push_back(buffer);
+	this->buffer_space_total += buffer->total_size();
 }
 
 void Internal_Info_Summary::increment_num_stalls () {
 	this->num_stalls += 1;
+	this->total_num_stalls += 1;
 }
 
+// only the stall count is per cycle, the total is kept for the over time samples
 void Internal_Info_Summary::clear () {
-	this->message_id_to_packet_id_set_map->clear();
-	for (auto itr_buffer=this->buffer_to_flit_info_set_map->begin(); itr_buffer != this->buffer_to_flit_info_set_map->end(); itr_buffer++) {
-		std::set<Flit_Info*, flit_info_comp>* flit_info_set = itr_buffer->second;
-		for (auto itr_flit_info = flit_info_set->begin(); itr_flit_info != flit_info_set->end(); itr_flit_info++) {
-			Flit_Info* flit_info = *itr_flit_info;
-			delete(flit_info);
-		}
-		flit_info_set->clear();
-	}
-	this->buffer_space_occupied = 0;
-	this->buffer_space_total = 0;
 	this->num_stalls = 0;
 }
 
@@ -125,6 +54,65 @@ Node::Node (uint32_t node_id, void* network_id, uint32_t num_channels, uint32_t
 	this->num_neighbors = num_neighbors;
 	this->max_buffer_capacity = max_buffer_capacity;
 	this->type = type;
+	this->is_scheduled = false;
+	this->num_occupied_buffers = 0;
+	this->num_buffered_flits = 0;
+	this->buffer_slot_slab = NULL;
+	this->num_free_buffer_slots = 0;
+}
+
+// sized for num_buffers buffers of max_buffer_capacity, buffers beyond that get their own allocation
+void Node::init_buffer_slot_slab (uint32_t num_buffers) {
+	this->num_free_buffer_slots = num_buffers * Buffer::get_num_slots(this->max_buffer_capacity);
+	this->buffer_slot_slab = new Flit_Handle[this->num_free_buffer_slots];
+}
+
+Flit_Handle* Node::allocate_buffer_slots (uint32_t num_slots) {
+	if (num_slots > this->num_free_buffer_slots) return new Flit_Handle[num_slots];
+	Flit_Handle* slots = this->buffer_slot_slab;
+	this->buffer_slot_slab += num_slots;
+	this->num_free_buffer_slots -= num_slots;
+	return slots;
+}
+
+// active set bookkeeping only, the subclasses clear their buffers and channels
+void Node::reset () {
+	this->is_scheduled = false;
+	this->num_occupied_buffers = 0;
+	this->num_buffered_flits = 0;
+}
+
+void Node::schedule () {
+	// only the active set engine keeps a worklist
+	if (global_active_set == NULL) return;
+
+	bool was_scheduled;
+	#pragma omp atomic capture
+	{ was_scheduled = this->is_scheduled; this->is_scheduled = true; }
+
+	// only the first caller adds the node so it appears once in the worklist
+	if (!was_scheduled) global_active_set->insert(this);
+}
+
+void Node::unschedule () {
+	this->is_scheduled = false;
+}
+
+void Node::notify_flit_inserted (bool was_empty) {
+	#pragma omp atomic
+	this->num_buffered_flits += 1;
+	if (!was_empty) return;
+	#pragma omp atomic
+	this->num_occupied_buffers += 1;
+	this->schedule();
+}
+
+void Node::notify_flit_removed (bool is_empty) {
+	#pragma omp atomic
+	this->num_buffered_flits -= 1;
+	if (!is_empty) return;
+	#pragma omp atomic
+	this->num_occupied_buffers -= 1;
 }
 
 Processor::Processor (uint32_t node_id, 
@@ -133,22 +121,34 @@ Processor::Processor (uint32_t node_id,
 					  uint32_t num_neighbors, 
 					  uint32_t max_buffer_capacity) :
 Node(node_id, network_id, num_channels, num_neighbors, max_buffer_capacity, PROCESSOR) {
-	this->injection_buffer = new Buffer(this->max_buffer_capacity);
-	this->router_buffer = new Buffer(this->max_buffer_capacity);
+	// injection buffer and router buffer
+	this->init_buffer_slot_slab(2);
+	this->injection_buffer = new Buffer(this->max_buffer_capacity, this);
+	this->router_buffer = new Buffer(this->max_buffer_capacity, this);
+	this->flit_pool = new Flit_Pool();
 	this->num_flits_transmitted	= 0;
 	this->num_flits_received = 0;
 	this->transmitted_messages_vec = new std::vector<uint32_t>;
 	this->received_messages_vec = new std::vector<uint32_t>;
-	this->receive_message_flag = false;
-	this->transmit_message_flag = false;
+	this->tx_message_queue = NULL;
+	this->latency_histogram_set = NULL;
 }
 
-void Processor::init_tx_message_vec(std::vector<Message*>* tx_message_vec) {
-	this->tx_message_vec = tx_message_vec;
+// the processor owns the queue and histogram set it is handed, one it held before is freed
+void Processor::init_tx_message_queue(std::deque<Message>* tx_message_queue) {
+	delete this->tx_message_queue;
+	this->tx_message_queue = tx_message_queue;
 }
 
-void Processor::init_rx_message_map(std::map<uint32_t, int>* rx_message_id_to_num_flits_map) {
-	this->rx_message_id_to_num_flits_map = rx_message_id_to_num_flits_map;
+void Processor::init_latency_histogram_set(Latency_Histogram_Set* latency_histogram_set) {
+	delete this->latency_histogram_set;
+	this->latency_histogram_set = latency_histogram_set;
+}
+
+// for messages that show up while the simulation is running
+void Processor::enqueue_message(Message message) {
+	this->tx_message_queue->push_back(message);
+	this->schedule();
 }
 
 void Processor::init_connection (Node* node, Channel* input_channel, Channel* output_channel) {
@@ -167,36 +167,45 @@ void Processor::init_router_connection (Router* router, Channel* input_channel,
 	this->router_input_channel->init_buffer_lst(buffer_lst, 1);
 }
 
+// take a packet slot from this processor's flit pool for every packet, then queue up its flit handles
 void Processor::inject_message(Message* message) {
-	for (uint32_t i=0; i < message->num_packets; i++) {
-		Packet* packet = message->packet_lst[i];
-		Head_Flit* head_flit = packet->head;
-		this->injection_buffer->insert_flit(head_flit);
-		for (uint32_t j=0; j < num_data_flits_per_packet; j++) {
-			Flit* data_flit = packet->payload[j];
-			this->injection_buffer->insert_flit(data_flit);
+	uint32_t num_packets = message->get_num_packets();
+	for (uint32_t i=0; i < num_packets; i++) {
+		uint32_t packet_slot = this->flit_pool->new_packet(message->message_id, i, num_packets, message->dest);
+		for (uint32_t j=0; j <= tail_flit_index; j++) {
+			this->injection_buffer->insert_flit(make_flit_handle(packet_slot, j));
 		}
-		Tail_Flit* tail_flit = packet->tail;
-		this->injection_buffer->insert_flit(tail_flit);
-		delete(packet->payload);
-		delete(packet);
 	}
 }
 
+bool Processor::has_pending_work () {
+	bool has_message_to_transmit = !this->tx_message_queue->empty();
+	bool has_flits_to_transmit = this->num_occupied_buffers > 0;
+	return has_message_to_transmit || has_flits_to_transmit;
+}
+
+// clock cycle at which the processor next puts a flit into the network, -1 if it never will
+uint32_t Processor::get_next_injection_time () {
+	if (!this->injection_buffer->is_empty()) return global_clock;
+	if (this->tx_message_queue->empty()) return (uint32_t)-1;
+	return std::max(this->tx_message_queue->front().release_time, global_clock);
+}
+
 void Processor::tx () {
-	// if injection buffer is empty, add new message to transmit
+	// if injection buffer is empty, add new message to transmit once it is released
 	if (this->injection_buffer->is_empty()) {
-		if (this->tx_message_vec->size() != 0) {
-			// this->transmit_message_flag = true;
-			auto itr = this->tx_message_vec->begin();
-			Message* message = *itr;
+		if (!this->tx_message_queue->empty() && this->tx_message_queue->front().is_ready()) {
+			Message* message = &this->tx_message_queue->front();
 			this->inject_message(message);
 			this->transmitted_messages_vec->push_back(message->message_id);
-			global_message_transmission_info[message->message_id]->tx_time = (int)global_clock;
+			global_message_transmission_info[message->message_id].tx_time = (int)global_clock;
+			if (global_message_transmission_info[message->message_id].creation_time < 0) {
+				global_message_transmission_info[message->message_id].creation_time = (int)global_clock;
+				global_completion_tracker->record_created(&global_message_transmission_info[message->message_id]);
+			}
+			global_completion_tracker->record_injected();
 			
-			delete(message->packet_lst);
-			delete(message);
-			this->tx_message_vec->erase(itr);
+			this->tx_message_queue->pop_front();
 		}
 	}
 
@@ -209,56 +218,72 @@ void Processor::tx () {
 void Processor::rx () {
 	// look at router input channel and if it is closed for transmission, then execute transmission
 	if (!(this->router_input_channel->is_open_for_transmission())) {
-		this->receive_message_flag = true;
 		FLIT_TYPE flit_type = this->router_input_channel->execute_transmission(this->router_buffer);
 		if (flit_type == TAIL) this->router_input_channel->reset_transmission_state();
 
 		// remove flit from buffer and adjust message id to num flits map
-		Flit* flit = this->router_buffer->remove_flit();
+		Flit_Handle flit = this->router_buffer->remove_flit();
+		uint32_t message_id = get_flit_message_id(flit);
 		this->num_flits_received++;
 
 		// if flit was a head flit, increment avg distance
-		if (flit->type == HEAD) {
-			Head_Flit* head_flit = (Head_Flit*)flit;
-			float normalized_distance = (float)head_flit->distance / (float)head_flit->num_packets;
-			global_message_transmission_info[flit->message_id]->avg_packet_distance += normalized_distance;
+		if (flit_type == HEAD) {
+			float normalized_distance = (float)get_flit_distance(flit) / (float)get_flit_num_packets(flit);
+			global_message_transmission_info[message_id].avg_packet_distance += normalized_distance;
 		}
-		auto itr = this->rx_message_id_to_num_flits_map->find(flit->message_id);
-		assert(itr != this->rx_message_id_to_num_flits_map->end());
-		itr->second--;
+		assert(global_message_transmission_info[message_id].num_flits_remaining > 0);
+		global_message_transmission_info[message_id].num_flits_remaining--;
 
 		// check if we received the entire message
-		if (itr->second == 0) {
-			// this->receive_message_flag = true;
-			this->received_messages_vec->push_back(flit->message_id);
-			global_message_transmission_info[flit->message_id]->rx_time = (int)global_clock;
-			uint32_t rx_time = (uint32_t)global_message_transmission_info[flit->message_id]->rx_time;
-			uint32_t tx_time = (uint32_t)global_message_transmission_info[flit->message_id]->tx_time;
-			global_message_transmission_info[flit->message_id]->latency = rx_time - tx_time;
+		if (global_message_transmission_info[message_id].num_flits_remaining == 0) {
+			this->received_messages_vec->push_back(message_id);
+			global_message_transmission_info[message_id].rx_time = (int)global_clock;
+			uint32_t rx_time = (uint32_t)global_message_transmission_info[message_id].rx_time;
+			uint32_t creation_time = (uint32_t)global_message_transmission_info[message_id].creation_time;
+			global_message_transmission_info[message_id].latency = rx_time - creation_time;
+			if (global_message_transmission_info[message_id].batch_id == TAGGED_BATCH) {
+				this->latency_histogram_set->record(global_message_transmission_info[message_id].latency,
+													(uint32_t)global_message_transmission_info[message_id].avg_packet_distance,
+													global_message_transmission_info[message_id].tx_processor_id,
+													global_message_transmission_info[message_id].rx_processor_id);
+			}
+			global_completion_tracker->record_delivered(global_message_transmission_info[message_id].batch_id);
 		}
 
-		delete(flit);
-	}
-
-	// updated tx status
-	if (this->router_output_channel->is_successful_transmission()) {
-		this->transmit_message_flag = true;
-		this->num_flits_transmitted++;
+		// the tail is the last flit of its packet, so the packet slot can be reused
+		if (flit_type == TAIL) Flit_Pool::release_packet(get_flit_packet_slot(flit));
 	}
 }
 
-bool Processor::did_transmit_message () {
-	bool transmit_message_flag = this->transmit_message_flag;
-	this->transmit_message_flag = false;
-	return transmit_message_flag;
+// called by the router when it pulls in a flit from the injection buffer
+void Processor::record_flit_transmitted () {
+	this->num_flits_transmitted++;
 }
 
-bool Processor::did_receive_message () {
-	bool receive_message_flag = this->receive_message_flag;
-	this->receive_message_flag = false;
-	return receive_message_flag;
+Buffer* Processor::get_injection_buffer () {return this->injection_buffer;}
+
+Buffer* Processor::get_router_buffer () {return this->router_buffer;}
+
+Channel* Processor::get_router_input_channel () {return this->router_input_channel;}
+
+Flit_Pool* Processor::get_flit_pool () {return this->flit_pool;}
+
+// the message queue and latency histograms of the finished run are freed, the next run's setup hands in new ones
+void Processor::reset () {
+	Node::reset();
+	this->injection_buffer->reset();
+	this->router_buffer->reset();
+	this->router_input_channel->reset();
+	this->flit_pool->reset();
+	this->num_flits_transmitted = 0;
+	this->num_flits_received = 0;
+	this->transmitted_messages_vec->clear();
+	this->received_messages_vec->clear();
+	this->init_tx_message_queue(NULL);
+	this->init_latency_histogram_set(NULL);
 }
 
+
 Router::Router (uint32_t node_id, 
 				void* network_id,
 				uint32_t num_channels, 
@@ -271,13 +296,15 @@ Router::Router (uint32_t node_id,
 Node(node_id, network_id, num_channels, num_neighbors, max_buffer_capacity, ROUTER) {
 
 	this->num_virtual_channels = num_virtual_channels;
+	// every input channel gets one buffer per virtual channel
+	this->init_buffer_slot_slab(this->num_channels * this->num_virtual_channels);
 	this->routing_func = routing_func;
 	this->flow_control_func = flow_control_func;
 	this->flow_control_granularity = flow_control_granularity;
-	this->input_channel_to_buffers_map = new std::map<Channel*, Buffer**>;
+	this->input_channel_to_buffers_map = new std::map<Channel*, Buffer**, channel_comp>;
 	this->neighbor_to_io_channels_map = new std::map<Router*, std::vector<IO_Channel*>*>;
-	this->flit_info_to_router_id_cache = new Flit_Info_To_Router_ID_Cache;
 	this->internal_info_summary = new Internal_Info_Summary;
+	this->random_stream = new Random_Stream(ROUTER_STREAM, this->node_id);
 }
 
 void Router::init_connection (Node* node, Channel* input_channel, Channel* output_channel) {
@@ -290,9 +317,9 @@ void Router::init_router_connection (Router* neighbor, Channel* input_channel, C
 	// add to input_channel_to_buffers_map
 	Buffer** input_channel_buffers = new Buffer*[this->num_virtual_channels];
 	for (uint32_t i=0; i < this->num_virtual_channels; i++) {
-		Buffer* new_buffer = new Buffer(this->max_buffer_capacity);
+		Buffer* new_buffer = new Buffer(this->max_buffer_capacity, this);
 		input_channel_buffers[i] = new_buffer;
-		this->internal_info_summary->init_buffer_in_map(new_buffer);
+		this->internal_info_summary->init_buffer(new_buffer);
 	}
 	this->input_channel_to_buffers_map->insert({input_channel, input_channel_buffers});
 	input_channel->init_buffer_lst(input_channel_buffers, this->num_virtual_channels);
@@ -336,6 +363,9 @@ std::vector<IO_Channel*>* Router::get_io_channel_vec(uint32_t neighbor_router_id
 }
 
 void Router::tx () {
+	// draws for this cycle only depend on router id and clock cycle
+	this->random_stream->seek(global_clock);
+
 	// loop through all input channels
 	for (auto itr=this->input_channel_to_buffers_map->begin(); itr != this->input_channel_to_buffers_map->end(); itr++) {
 
@@ -348,24 +378,28 @@ void Router::tx () {
 		for (uint32_t i=0; i < this->num_virtual_channels; i++) {
 			buffer_order.push_back(i);
 		}
-		random_shuffle(buffer_order.begin(), buffer_order.end());
+		this->random_stream->shuffle(&buffer_order);
 
 		for (auto itr_buffer_idx=buffer_order.begin(); itr_buffer_idx != buffer_order.end(); itr_buffer_idx++) {
 			Buffer* buffer = buffers[*itr_buffer_idx];
 			if (buffer->is_empty()) continue;
 
-			Flit* flit = buffer->peek_flit();
+			Flit_Handle flit = buffer->peek_flit();
+			FLIT_TYPE flit_type = get_flit_type(flit);
 
-			// determine where to route next flit in buffer to
-			uint32_t next_dest_router_id = (*(this->routing_func))(flit, 
-																   this->node_id, 
-																   this->network_id,
-																   this->flit_info_to_router_id_cache,
-																   this->neighbor_to_io_channels_map);
+			// a HEAD is routed every time it is at the front, the rest of its packet follows the route kept in the buffer
+			if (flit_type == HEAD) {
+				uint32_t next_dest_router_id = (*(this->routing_func))(flit, 
+																	   this->node_id, 
+																	   this->network_id,
+																	   this->neighbor_to_io_channels_map);
+				buffer->set_route(next_dest_router_id, this->get_io_channel_vec(next_dest_router_id));
+			}
+			assert(buffer->is_routed);
 
 			bool is_proposed = false;
 			bool is_failed = false;
-			std::vector<IO_Channel*>* io_channel_vec = this->get_io_channel_vec(next_dest_router_id);
+			std::vector<IO_Channel*>* io_channel_vec = buffer->route_io_channel_vec;
 
 			for (auto itr_io_channel=io_channel_vec->begin(); itr_io_channel != io_channel_vec->end(); itr_io_channel++) {
 				Channel* output_channel = (*itr_io_channel)->output_channel;
@@ -390,7 +424,7 @@ void Router::tx () {
 					is_proposed = true;
 
 					// if granularity is packet and if we are transmitting a tail flit, we need to unlock channel
-					if (this->flow_control_granularity == PACKET && flit->type == TAIL) output_channel->unlock();
+					if (this->flow_control_granularity == PACKET && flit_type == TAIL) output_channel->unlock();
 
 					break;
 				}
@@ -404,10 +438,10 @@ void Router::tx () {
 
 					bool can_propose;
 					// if granularity is packet, then check if this channel is locked
-					if (this->flow_control_granularity == PACKET) can_propose = output_channel->is_unlocked();
+					if (this->flow_control_granularity == PACKET) can_propose = output_channel->can_lock_for_flit(flit);
 					// if granuliary is flit, then check if there is a dest buffer reserved for it
 					else if (this->flow_control_granularity == FLIT) {
-						can_propose = output_channel->is_dest_buffer_unreserved();
+						can_propose = output_channel->is_dest_buffer_unreserved(flit);
 					}
 					// should never come here
 					else can_propose = true;
@@ -419,7 +453,7 @@ void Router::tx () {
 						is_proposed = true;
 
 						// if granularity is packet and if we are transmitting a Head flit, we need to unlock channel
-						if (this->flow_control_granularity == PACKET && flit->type == HEAD) output_channel->lock();
+						if (this->flow_control_granularity == PACKET && flit_type == HEAD) output_channel->lock();
 
 						break;
 					}
@@ -428,6 +462,7 @@ void Router::tx () {
 
 			if (is_proposed == false || is_failed == true) {
 				this->internal_info_summary->increment_num_stalls();
+				buffer->num_blocked_cycles++;
 			}
 		}
 	}
@@ -453,9 +488,7 @@ void Router::rx() {
 
 			// only look at buffers which are reserved for this flit
 			if (buffer->is_reserved_for_flit(proposed_message_id, proposed_packet_id)) {
-				bool is_not_full = buffer->is_not_full();
-				bool is_empty = buffer->is_empty();
-				if (is_not_full || is_empty) {
+				if (buffer->can_accept_flit()) {
 					FLIT_TYPE flit_type = input_channel->execute_transmission(buffer);
 					assert(flit_type != HEAD);
 					if (flit_type == TAIL) buffer->unreserve_buffer();
@@ -475,14 +508,15 @@ void Router::rx() {
 
 		// check if flit has already been pulled in by executing transmission or failed transmission because buffer was full
 		if (is_executed == false && is_failed == false) {
-			// check if there is an open buffer
-			for (uint32_t i=0; i < this->num_virtual_channels; i++) {
+			// check if there is an open buffer among the ones the HEAD may take
+			uint32_t vc_begin, vc_end;
+			input_channel->get_virtual_channel_range(input_channel->transmission_state->tx_buffer->peek_flit(), &vc_begin, &vc_end);
+			bool is_atomic = is_atomic_virtual_channel_allocation();
+			for (uint32_t i=vc_begin; i < vc_end; i++) {
 				Buffer* buffer = buffers[i];
 
-				if (buffer->is_unreserved()) {
-					bool is_not_full = buffer->is_not_full();
-					bool is_empty = buffer->is_empty();
-					if (is_not_full || is_empty) {
+				if (buffer->is_unreserved() && (!is_atomic || buffer->can_accept_packet())) {
+					if (buffer->can_accept_flit()) {
 						FLIT_TYPE flit_type = input_channel->execute_transmission(buffer);
 						assert(flit_type == HEAD);
 						if (flit_type == HEAD) buffer->reserve_buffer(proposed_message_id, proposed_packet_id);
@@ -501,36 +535,44 @@ void Router::rx() {
 	}
 }
 
-void Router::erase_cached_routing (uint32_t message_id, uint32_t packet_id) {
-	Flit_Info flit_info;
-	flit_info.message_id = message_id;
-	flit_info.packet_id = packet_id;
-	this->flit_info_to_router_id_cache->erase(&flit_info);
-}
-
+// occupancy is kept up to date by the buffers, this only closes out the cycle
 void Router::update_internal_info_summary () {
 	for (auto itr_channel=this->input_channel_to_buffers_map->begin(); itr_channel != this->input_channel_to_buffers_map->end(); itr_channel++) {
 		Buffer** buffers = itr_channel->second;
 		for (uint32_t i=0; i < this->num_virtual_channels; i++) {
-			Buffer* buffer = buffers[i];
-			for (auto itr_buffer=buffer->begin(); itr_buffer != buffer->end(); itr_buffer++) {
-				uint32_t message_id = (*itr_buffer)->message_id;
-				uint32_t packet_id = (*itr_buffer)->packet_id;
-				this->internal_info_summary->insert(buffer, message_id, packet_id);
-			}
-			this->internal_info_summary->buffer_space_occupied += buffer->occupied_size();
-			this->internal_info_summary->buffer_space_total += buffer->total_size();
+			buffers[i]->settle();
 		}
 		Channel* input_channel = itr_channel->first;
 		input_channel->clear_transmission_status();
 	}
 }
 
-uint32_t Router::get_buffer_space_occupied () {return this->internal_info_summary->buffer_space_occupied;}
+bool Router::has_pending_work () {
+	// a stall means a flit is still waiting in a buffer or on an input channel
+	bool has_flits_to_transmit = this->num_occupied_buffers > 0;
+	bool has_stalled_transmission = this->internal_info_summary->num_stalls > 0;
+	return has_flits_to_transmit || has_stalled_transmission;
+}
+
+uint32_t Router::get_buffer_space_occupied () {return this->num_buffered_flits;}
 
 uint32_t Router::get_buffer_space_total () {return this->internal_info_summary->buffer_space_total;}
 
 uint32_t Router::get_num_stalls () {return this->internal_info_summary->num_stalls;}
+uint32_t Router::get_total_num_stalls () {return this->internal_info_summary->total_num_stalls;}
+
+// a router owns its input channels and their buffers. the random stream is rebuilt since the seed may have changed
+void Router::reset () {
+	Node::reset();
+	for (auto itr=this->input_channel_to_buffers_map->begin(); itr != this->input_channel_to_buffers_map->end(); itr++) {
+		itr->first->reset();
+		for (uint32_t i=0; i < this->num_virtual_channels; i++) itr->second[i]->reset();
+	}
+	this->internal_info_summary->clear();
+	this->internal_info_summary->total_num_stalls = 0;
+	delete this->random_stream;
+	this->random_stream = new Random_Stream(ROUTER_STREAM, this->node_id);
+}
 
 void Router::clear_internal_info_summary () {
 	this->internal_info_summary->clear();
@@ -568,9 +610,9 @@ void Processor_Router::init_processor_connection (Processor* processor, Channel*
 
 	this->processor_buffer_lst = new Buffer*[this->num_virtual_channels];
 	for (uint32_t i=0; i < this->num_virtual_channels; i++) {
-		Buffer* new_buffer = new Buffer(this->max_buffer_capacity);
+		Buffer* new_buffer = new Buffer(this->max_buffer_capacity, this);
 		this->processor_buffer_lst[i] = new_buffer;
-		this->internal_info_summary->init_buffer_in_map(new_buffer);
+		this->internal_info_summary->init_buffer(new_buffer);
 	}
 	input_channel_to_buffers_map->insert({input_channel, this->processor_buffer_lst});
 	input_channel->init_buffer_lst(this->processor_buffer_lst, this->num_virtual_channels);
@@ -582,11 +624,21 @@ void Processor_Router::init_processor_connection (Processor* processor, Channel*
 	this->processor_io_channel_vec->push_back(processor_io_channel);
 }
 
+// the message to packets view is built from the buffer contents only when asked for
 void Internal_Info_Summary::print () {
-	for(auto itr_message=this->message_id_to_packet_id_set_map->begin(); itr_message != this->message_id_to_packet_id_set_map->end(); itr_message++) {
+	std::map<uint32_t, std::set<uint32_t>> message_id_to_packet_id_set_map;
+	for (uint32_t i=0; i < this->buffer_vec->size(); i++) {
+		Buffer* buffer = (*this->buffer_vec)[i];
+		for (auto itr_buffer=buffer->begin(); itr_buffer != buffer->end(); itr_buffer++) {
+			uint32_t message_id = get_flit_message_id(*itr_buffer);
+			message_id_to_packet_id_set_map[message_id].insert(get_flit_packet_id(*itr_buffer));
+		}
+	}
+
+	for(auto itr_message=message_id_to_packet_id_set_map.begin(); itr_message != message_id_to_packet_id_set_map.end(); itr_message++) {
 		printf("\tmessage %d\n", itr_message->first);
 		printf("\tpackets ");
-		for (auto itr_packet=itr_message->second->begin(); itr_packet != itr_message->second->end(); itr_packet++) {
+		for (auto itr_packet=itr_message->second.begin(); itr_packet != itr_message->second.end(); itr_packet++) {
 			printf("%d,", *itr_packet);
 		}
 		printf("\n");
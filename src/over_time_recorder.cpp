@@ -0,0 +1,74 @@
+#include <stdint.h>
+#include <string.h>
+#include <cassert>
+#include <algorithm>
+
+#include "over_time_recorder.h"
+#include "stats_writer.h"
+
+static void add_window_stat (Window_Stat* stat, uint32_t val, bool is_first) {
+	stat->sum += val;
+	stat->min = is_first ? val : std::min(stat->min, val);
+	stat->max = is_first ? val : std::max(stat->max, val);
+}
+
+Over_Time_Recorder::Over_Time_Recorder (Stats_Writer* stats_writer, uint32_t window_size, uint32_t ring_size) {
+	assert(window_size > 0);
+	this->stats_writer = stats_writer;
+	this->window_size = window_size;
+	this->ring_size = ring_size;
+	memset(&this->current_window, 0, sizeof(Over_Time_Window));
+	this->window_ring = NULL;
+	if (this->ring_size > 0) this->window_ring = new Over_Time_Window[this->ring_size];
+	this->ring_head = 0;
+	this->num_ring_windows = 0;
+}
+
+Over_Time_Recorder::~Over_Time_Recorder () {
+	delete[] this->window_ring;
+}
+
+// hands the current window to the stats writer or the ring, overwriting the oldest window once the ring is full
+void Over_Time_Recorder::finish_window () {
+	if (this->ring_size == 0) {
+		this->stats_writer->append_over_time_row(&this->current_window);
+	}
+	else {
+		uint32_t slot = (this->ring_head + this->num_ring_windows) % this->ring_size;
+		this->window_ring[slot] = this->current_window;
+		if (this->num_ring_windows < this->ring_size) this->num_ring_windows++;
+		else this->ring_head = (this->ring_head + 1) % this->ring_size;
+	}
+	memset(&this->current_window, 0, sizeof(Over_Time_Window));
+}
+
+// counts are summed over the sample's cycles, occupancy is the value at the end of the sample
+void Over_Time_Recorder::add_sample (uint32_t num_cycles, uint32_t tx_flits, uint32_t rx_flits, uint32_t num_stalls, uint32_t buffers_space_occupied, uint32_t buffers_space_total) {
+	Over_Time_Window* window = &this->current_window;
+	bool is_first = window->num_samples == 0;
+	window->num_cycles += num_cycles;
+	window->num_samples++;
+	add_window_stat(&window->tx_flits, tx_flits, is_first);
+	add_window_stat(&window->rx_flits, rx_flits, is_first);
+	add_window_stat(&window->num_stalls, num_stalls, is_first);
+	add_window_stat(&window->buffers_space_occupied, buffers_space_occupied, is_first);
+	window->buffers_space_total = buffers_space_total;
+	if (window->num_samples == this->window_size) this->finish_window();
+}
+
+// fast forwarded cycles have nothing to sample, so they close the current window and get one of their own
+void Over_Time_Recorder::add_idle_cycles (uint32_t num_cycles, uint32_t buffers_space_total) {
+	if (this->current_window.num_samples > 0) this->finish_window();
+	this->current_window.num_cycles = num_cycles;
+	this->current_window.buffers_space_total = buffers_space_total;
+	this->finish_window();
+}
+
+// writes out the partial window and whatever the ring holds, oldest first
+void Over_Time_Recorder::close () {
+	if (this->current_window.num_samples > 0) this->finish_window();
+	for (uint32_t i=0; i < this->num_ring_windows; i++) {
+		this->stats_writer->append_over_time_row(&this->window_ring[(this->ring_head + i) % this->ring_size]);
+	}
+	this->num_ring_windows = 0;
+}
@@ -0,0 +1,103 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "random_stream.h"
+
+uint32_t global_random_seed = 15418;
+bool is_deterministic_random = false;
+
+#define PHILOX_M0 0xD2511F53
+#define PHILOX_M1 0xCD9E8D57
+#define PHILOX_W0 0x9E3779B9
+#define PHILOX_W1 0xBB67AE85
+#define PHILOX_NUM_ROUNDS 10
+
+void init_random_streams (uint32_t seed, bool is_deterministic) {
+	global_random_seed = seed;
+	is_deterministic_random = is_deterministic;
+	srand(seed);
+}
+
+Random_Stream::Random_Stream (RANDOM_STREAM_DOMAIN domain, uint32_t stream_id) {
+	this->key[0] = global_random_seed;
+	this->key[1] = stream_id;
+	this->counter[0] = 0; // block index within epoch
+	this->counter[1] = 0; // epoch
+	this->counter[2] = (uint32_t)domain;
+	this->counter[3] = 0;
+	this->block_idx = 4;
+}
+
+// start drawing from the beginning of another epoch, e.g. a clock cycle or message id
+void Random_Stream::seek (uint32_t epoch) {
+	this->counter[0] = 0;
+	this->counter[1] = epoch;
+	this->block_idx = 4;
+}
+
+void Random_Stream::generate_block () {
+	uint32_t ctr[4] = {this->counter[0], this->counter[1], this->counter[2], this->counter[3]};
+	uint32_t k0 = this->key[0];
+	uint32_t k1 = this->key[1];
+
+	for (uint32_t i=0; i < PHILOX_NUM_ROUNDS; i++) {
+		uint64_t product_0 = (uint64_t)PHILOX_M0 * ctr[0];
+		uint64_t product_1 = (uint64_t)PHILOX_M1 * ctr[2];
+		uint32_t next_ctr_0 = (uint32_t)(product_1 >> 32) ^ ctr[1] ^ k0;
+		uint32_t next_ctr_1 = (uint32_t)product_1;
+		uint32_t next_ctr_2 = (uint32_t)(product_0 >> 32) ^ ctr[3] ^ k1;
+		uint32_t next_ctr_3 = (uint32_t)product_0;
+		ctr[0] = next_ctr_0;
+		ctr[1] = next_ctr_1;
+		ctr[2] = next_ctr_2;
+		ctr[3] = next_ctr_3;
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+
+	for (uint32_t i=0; i < 4; i++) this->block[i] = ctr[i];
+	this->counter[0]++;
+	this->block_idx = 0;
+}
+
+uint32_t Random_Stream::next () {
+	if (!is_deterministic_random) return (uint32_t)rand();
+	if (this->block_idx == 4) this->generate_block();
+	return this->block[this->block_idx++];
+}
+
+uint32_t Random_Stream::next_below (uint32_t bound) {
+	return this->next() % bound;
+}
+
+// uniform in [0, 1)
+double Random_Stream::next_unit () {
+	if (!is_deterministic_random) return (double)rand() / ((double)RAND_MAX + 1.0);
+	return (double)this->next() / 4294967296.0;
+}
+
+// Fisher-Yates shuffle
+void Random_Stream::shuffle (std::vector<uint32_t>* vec) {
+	for (uint32_t i=vec->size(); i > 1; i--) {
+		uint32_t j = this->next_below(i);
+		uint32_t tmp = (*vec)[i-1];
+		(*vec)[i-1] = (*vec)[j];
+		(*vec)[j] = tmp;
+	}
+}
+
+// the libc fallback shares one hidden state, so only deterministic streams can be saved
+void Random_Stream::save_state (Random_Stream_State* state) {
+	for (uint32_t i=0; i < 2; i++) state->key[i] = this->key[i];
+	for (uint32_t i=0; i < 4; i++) state->counter[i] = this->counter[i];
+	for (uint32_t i=0; i < 4; i++) state->block[i] = this->block[i];
+	state->block_idx = this->block_idx;
+}
+
+void Random_Stream::restore_state (Random_Stream_State* state) {
+	for (uint32_t i=0; i < 2; i++) this->key[i] = state->key[i];
+	for (uint32_t i=0; i < 4; i++) this->counter[i] = state->counter[i];
+	for (uint32_t i=0; i < 4; i++) this->block[i] = state->block[i];
+	this->block_idx = state->block_idx;
+}
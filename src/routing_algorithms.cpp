@@ -15,7 +15,7 @@ extern void* network_info;
 uint32_t convert_network_id_to_router_id(void* network_id) {
 	uint32_t router_id;
 
-	if (network_type == MESH) {
+	if (network_type == MESH || network_type == TORUS) {
 		Mesh_Info* mesh_info = (Mesh_Info*)network_info;
 		Mesh_ID* mesh_id = (Mesh_ID*)network_id;
 		router_id = (mesh_id->y * mesh_info->num_cols) + mesh_id->x;
@@ -24,76 +24,20 @@ uint32_t convert_network_id_to_router_id(void* network_id) {
 	return router_id;
 }
 
-void* convert_router_id_to_network_id(uint32_t router_id) {
+// fills in a caller owned network id, so routing does not allocate
+void convert_router_id_to_network_id(uint32_t router_id, void* network_id) {
 
-	if (network_type == MESH) {
+	if (network_type == MESH || network_type == TORUS) {
 		Mesh_Info* mesh_info = (Mesh_Info*)network_info;
-		Mesh_ID* mesh_id = new Mesh_ID;
+		Mesh_ID* mesh_id = (Mesh_ID*)network_id;
 		mesh_id->x = (uint32_t)(router_id % mesh_info->num_cols);
 		mesh_id->y = (uint32_t)(router_id / mesh_info->num_cols);
-		return (void*)mesh_id;
-	}
-
-	else assert(false);
-}
-
-int routing_cache_lookup(Flit* flit, 
-						 uint32_t curr_router_id,
-						 void* curr_network_id,
-						 Flit_Info_To_Router_ID_Cache* flit_info_to_router_id_cache) {
-
-	// construct head flit info for flit
-	Flit_Info* flit_info = new Flit_Info;
-	flit_info->message_id = flit->message_id;
-	flit_info->packet_id = flit->packet_id;
-
-	if (flit->type == HEAD) {
-
-		if (network_type == MESH) {
-			Mesh_ID* curr_mesh_id = (Mesh_ID*)curr_network_id;
-			uint32_t final_dest_router_id = ((Head_Flit*)flit)->dest;
-			Mesh_ID* final_dest_mesh_id = (Mesh_ID*)convert_router_id_to_network_id(final_dest_router_id);
-
-			// check if flit needs to go to connected processor
-			if ((curr_mesh_id->x == final_dest_mesh_id->x) && (curr_mesh_id->y == final_dest_mesh_id->y)) {
-				flit_info_to_router_id_cache->insert(flit_info, curr_router_id);
-				return (int)curr_router_id;
-			}
-
-			// check if this is a retry because head did not go through in previous transmission
-			else if (flit_info_to_router_id_cache->is_in(flit_info)) {
-				flit_info_to_router_id_cache->erase(flit_info);
-				delete(flit_info);
-				return -1;
-			}
-
-			else return -1;
-		}
-
-		// add more network types here
-		else assert(false);
-	} 
-
-	// if flit is a data flit, then pull the next router id from the map
-	else if (flit->type == DATA) {
-		uint32_t next_router_id = flit_info_to_router_id_cache->find(flit_info);
-		delete(flit_info);
-		return (int)next_router_id;
-	}
-
-	// if flit is a data flit, then a) pull the next router id from the map and b) delete entry in map
-	// delete entry because then we route packets individually
-	else if (flit->type == TAIL) {
-		uint32_t next_router_id = flit_info_to_router_id_cache->find(flit_info);
-		delete(flit_info);
-		return (int)next_router_id;
 	}
 
 	else assert(false);
-	return -1;
 }
 
-bool is_unreserved_buffer(void* network_id, std::map<Router*, std::vector<IO_Channel*>*>* neighbor_to_io_channels_map) {
+bool is_unreserved_buffer(Flit_Handle flit, void* network_id, std::map<Router*, std::vector<IO_Channel*>*>* neighbor_to_io_channels_map) {
 	uint32_t next_router_id = convert_network_id_to_router_id(network_id);
 	for (auto itr_router=neighbor_to_io_channels_map->begin(); itr_router != neighbor_to_io_channels_map->end(); itr_router++) {
 		Router* router = itr_router->first;
@@ -101,7 +45,7 @@ bool is_unreserved_buffer(void* network_id, std::map<Router*, std::vector<IO_Cha
 			std::vector<IO_Channel*>* io_channel_vec = itr_router->second;
 			for (auto itr_channel=io_channel_vec->begin(); itr_channel != io_channel_vec->end(); itr_channel++) {
 				Channel* output_channel = (*itr_channel)->output_channel;
-				if (output_channel->is_dest_buffer_unreserved()) return true;
+				if (output_channel->is_dest_buffer_unreserved(flit)) return true;
 			}
 			return false;
 		}
@@ -109,37 +53,85 @@ bool is_unreserved_buffer(void* network_id, std::map<Router*, std::vector<IO_Cha
 	return false;
 }
 
+// a torus only hands a virtual channel to a new packet once the previous one has left it, so no packet ever
+// waits behind one of another class and a packet that is let in always fits if a buffer holds a whole packet
+bool is_atomic_virtual_channel_allocation() {
+	return network_type == TORUS;
+}
+
+// going up the ring, a packet that still has to cross the dateline sits above its destination. going down, below it
+static bool is_past_dateline(uint32_t hop_begin, uint32_t hop_end, uint32_t dest, uint32_t ring_size) {
+	if (hop_end == (hop_begin + 1) % ring_size) return hop_end <= dest;
+	return hop_end >= dest;
+}
+
+/*
+ * Virtual channels a flit may take at the end of a hop. On a torus the lowest and highest are
+ * escape channels, the low one for packets that still have to cross the ring's dateline, its
+ * wraparound link, and the high one for packets that crossed it or never will. Neither class has
+ * a cycle in a ring, so xy routing over them cannot deadlock. The channels in between are open to
+ * any hop of a minimal route, and since the xy hop can always fall back to its escape channel,
+ * adaptive routing cannot deadlock either. Routing goes the shorter way around, so whether a packet
+ * has crossed follows from where the hop ends and where it is going, nothing is kept in the flit.
+ */
+void get_virtual_channel_range(Flit_Handle flit, void* source_network_id, void* dest_network_id, uint32_t num_virtual_channels, uint32_t* vc_begin, uint32_t* vc_end) {
+	*vc_begin = 0;
+	*vc_end = num_virtual_channels;
+	if (network_type != TORUS) return;
+
+	// a processor and its router share their coordinates, so the injection channel has every virtual channel
+	Mesh_Info* mesh_info = (Mesh_Info*)network_info;
+	Mesh_ID* source_mesh_id = (Mesh_ID*)source_network_id;
+	Mesh_ID* dest_mesh_id = (Mesh_ID*)dest_network_id;
+	bool is_x_hop = source_mesh_id->x != dest_mesh_id->x;
+	if (!is_x_hop && source_mesh_id->y == dest_mesh_id->y) return;
+
+	Mesh_ID final_dest_mesh_id;
+	convert_router_id_to_network_id(get_flit_dest(flit), (void*)&final_dest_mesh_id);
+	bool is_past;
+	if (is_x_hop) is_past = is_past_dateline(source_mesh_id->x, dest_mesh_id->x, final_dest_mesh_id.x, mesh_info->num_cols);
+	else is_past = is_past_dateline(source_mesh_id->y, dest_mesh_id->y, final_dest_mesh_id.y, mesh_info->num_rows);
+	bool is_xy_hop = is_x_hop || source_mesh_id->x == final_dest_mesh_id.x;
+
+	*vc_begin = 1;
+	*vc_end = num_virtual_channels - 1;
+	if (is_xy_hop && is_past) *vc_end = num_virtual_channels;
+	else if (is_xy_hop) *vc_begin = 0;
+}
+
+// next coordinate on a ring the shorter way around, ties go up the ring
+static uint32_t get_ring_step(uint32_t curr, uint32_t dest, uint32_t ring_size) {
+	uint32_t up_distance = (dest + ring_size - curr) % ring_size;
+	if (2*up_distance <= ring_size) return (curr + 1) % ring_size;
+	return (curr + ring_size - 1) % ring_size;
+}
+
 
 /* Non-Adaptive Routing Algorithms */
 
 // Route along x dimension first, y dimension second
-uint32_t mesh_xy_routing(Flit* flit, 
+uint32_t mesh_xy_routing(Flit_Handle flit, 
 						 uint32_t curr_router_id,
 						 void* curr_network_id,
-						 Flit_Info_To_Router_ID_Cache* flit_info_to_router_id_cache,
 						 std::map<Router*, std::vector<IO_Channel*>*>* neighbor_to_io_channels_map) {
 
-	int cached_next_router_id = routing_cache_lookup(flit, curr_router_id, curr_network_id, flit_info_to_router_id_cache);
-	if (cached_next_router_id != -1) return (uint32_t)cached_next_router_id;
-
-	assert(flit->type == HEAD);
+	assert(get_flit_type(flit) == HEAD);
 
 	// convert to Mesh ID
 	Mesh_ID* curr_mesh_id = (Mesh_ID*)curr_network_id;
-	uint32_t final_dest_router_id = ((Head_Flit*)flit)->dest;
-	Mesh_ID* final_dest_mesh_id = (Mesh_ID*)convert_router_id_to_network_id(final_dest_router_id);
+	uint32_t final_dest_router_id = get_flit_dest(flit);
+	Mesh_ID final_dest_mesh_id;
+	convert_router_id_to_network_id(final_dest_router_id, (void*)&final_dest_mesh_id);
 
-	// construct head flit info for flit
-	Flit_Info* flit_info = new Flit_Info;
-	flit_info->message_id = flit->message_id;
-	flit_info->packet_id = flit->packet_id;
+	// check if flit needs to go to connected processor
+	if ((curr_mesh_id->x == final_dest_mesh_id.x) && (curr_mesh_id->y == final_dest_mesh_id.y)) return curr_router_id;
 
 	Mesh_ID next_dest_mesh_id;
 
 	// route x dimension first
-	if (curr_mesh_id->x != final_dest_mesh_id->x) {
+	if (curr_mesh_id->x != final_dest_mesh_id.x) {
 		// route east
-		if (curr_mesh_id->x < final_dest_mesh_id->x) {
+		if (curr_mesh_id->x < final_dest_mesh_id.x) {
 			next_dest_mesh_id.x = curr_mesh_id->x + 1;
 			next_dest_mesh_id.y = curr_mesh_id->y;
 		}
@@ -152,7 +144,7 @@ uint32_t mesh_xy_routing(Flit* flit,
 	// route y dimension second
 	else {
 		// route north
-		if (curr_mesh_id->y > final_dest_mesh_id->y) {
+		if (curr_mesh_id->y > final_dest_mesh_id.y) {
 			next_dest_mesh_id.x = curr_mesh_id->x;
 			next_dest_mesh_id.y = curr_mesh_id->y - 1;
 		}
@@ -164,39 +156,33 @@ uint32_t mesh_xy_routing(Flit* flit,
 	}
 
 	uint32_t next_router_id = convert_network_id_to_router_id((void*)&next_dest_mesh_id);
-	flit_info_to_router_id_cache->insert(flit_info, next_router_id);
 	return next_router_id;
 
 }
 
 // Route along y dimension first, x dimension second
-uint32_t mesh_yx_routing(Flit* flit, 
+uint32_t mesh_yx_routing(Flit_Handle flit, 
 						 uint32_t curr_router_id,
 						 void* curr_network_id,
-						 Flit_Info_To_Router_ID_Cache* flit_info_to_router_id_cache,
 						 std::map<Router*, std::vector<IO_Channel*>*>* neighbor_to_io_channels_map) {
 
-	int cached_next_router_id = routing_cache_lookup(flit, curr_router_id, curr_network_id, flit_info_to_router_id_cache);
-	if (cached_next_router_id != -1) return (uint32_t)cached_next_router_id;
-
-	assert(flit->type == HEAD);
+	assert(get_flit_type(flit) == HEAD);
 
 	// convert to Mesh ID
 	Mesh_ID* curr_mesh_id = (Mesh_ID*)curr_network_id;
-	uint32_t final_dest_router_id = ((Head_Flit*)flit)->dest;
-	Mesh_ID* final_dest_mesh_id = (Mesh_ID*)convert_router_id_to_network_id(final_dest_router_id);
+	uint32_t final_dest_router_id = get_flit_dest(flit);
+	Mesh_ID final_dest_mesh_id;
+	convert_router_id_to_network_id(final_dest_router_id, (void*)&final_dest_mesh_id);
 
-	// construct head flit info for flit
-	Flit_Info* flit_info = new Flit_Info;
-	flit_info->message_id = flit->message_id;
-	flit_info->packet_id = flit->packet_id;
+	// check if flit needs to go to connected processor
+	if ((curr_mesh_id->x == final_dest_mesh_id.x) && (curr_mesh_id->y == final_dest_mesh_id.y)) return curr_router_id;
 
 	Mesh_ID next_dest_mesh_id;
 
 	// route y dimension first
-	if (curr_mesh_id->y != final_dest_mesh_id->y) {
+	if (curr_mesh_id->y != final_dest_mesh_id.y) {
 		// route north
-		if (curr_mesh_id->y > final_dest_mesh_id->y) {
+		if (curr_mesh_id->y > final_dest_mesh_id.y) {
 			next_dest_mesh_id.x = curr_mesh_id->x;
 			next_dest_mesh_id.y = curr_mesh_id->y - 1;
 		}
@@ -209,7 +195,7 @@ uint32_t mesh_yx_routing(Flit* flit,
 	// route x dimension second
 	else {
 		// route east
-		if (curr_mesh_id->x < final_dest_mesh_id->x) {
+		if (curr_mesh_id->x < final_dest_mesh_id.x) {
 			next_dest_mesh_id.x = curr_mesh_id->x + 1;
 			next_dest_mesh_id.y = curr_mesh_id->y;
 		}
@@ -221,33 +207,50 @@ uint32_t mesh_yx_routing(Flit* flit,
 	}
 
 	uint32_t next_router_id = convert_network_id_to_router_id((void*)&next_dest_mesh_id);
-	flit_info_to_router_id_cache->insert(flit_info, next_router_id);
 	return next_router_id;
 }
 
+// Route along the x ring first, y ring second, each the shorter way around
+uint32_t torus_xy_routing(Flit_Handle flit, 
+						  uint32_t curr_router_id,
+						  void* curr_network_id,
+						  std::map<Router*, std::vector<IO_Channel*>*>* neighbor_to_io_channels_map) {
+
+	assert(get_flit_type(flit) == HEAD);
+
+	Mesh_Info* mesh_info = (Mesh_Info*)network_info;
+	Mesh_ID* curr_mesh_id = (Mesh_ID*)curr_network_id;
+	Mesh_ID final_dest_mesh_id;
+	convert_router_id_to_network_id(get_flit_dest(flit), (void*)&final_dest_mesh_id);
+
+	// check if flit needs to go to connected processor
+	if ((curr_mesh_id->x == final_dest_mesh_id.x) && (curr_mesh_id->y == final_dest_mesh_id.y)) return curr_router_id;
+
+	Mesh_ID next_dest_mesh_id = *curr_mesh_id;
+	if (curr_mesh_id->x != final_dest_mesh_id.x) next_dest_mesh_id.x = get_ring_step(curr_mesh_id->x, final_dest_mesh_id.x, mesh_info->num_cols);
+	else next_dest_mesh_id.y = get_ring_step(curr_mesh_id->y, final_dest_mesh_id.y, mesh_info->num_rows);
+
+	return convert_network_id_to_router_id((void*)&next_dest_mesh_id);
+}
+
 
 /* Adaptive Routing Algorithms */
 
-uint32_t mesh_adaptive_routing(Flit* flit, 
+uint32_t mesh_adaptive_routing(Flit_Handle flit, 
 						 uint32_t curr_router_id,
 						 void* curr_network_id,
-						 Flit_Info_To_Router_ID_Cache* flit_info_to_router_id_cache,
 						 std::map<Router*, std::vector<IO_Channel*>*>* neighbor_to_io_channels_map) {
 
-	int cached_next_router_id = routing_cache_lookup(flit, curr_router_id, curr_network_id, flit_info_to_router_id_cache);
-	if (cached_next_router_id != -1) return (uint32_t)cached_next_router_id;
-
-	assert(flit->type == HEAD);
+	assert(get_flit_type(flit) == HEAD);
 
 	// convert to Mesh ID
 	Mesh_ID* curr_mesh_id = (Mesh_ID*)curr_network_id;
-	uint32_t final_dest_router_id = ((Head_Flit*)flit)->dest;
-	Mesh_ID* final_dest_mesh_id = (Mesh_ID*)convert_router_id_to_network_id(final_dest_router_id);
+	uint32_t final_dest_router_id = get_flit_dest(flit);
+	Mesh_ID final_dest_mesh_id;
+	convert_router_id_to_network_id(final_dest_router_id, (void*)&final_dest_mesh_id);
 
-	// construct head flit info for flit
-	Flit_Info* flit_info = new Flit_Info;
-	flit_info->message_id = flit->message_id;
-	flit_info->packet_id = flit->packet_id;
+	// check if flit needs to go to connected processor
+	if ((curr_mesh_id->x == final_dest_mesh_id.x) && (curr_mesh_id->y == final_dest_mesh_id.y)) return curr_router_id;
 
 	bool is_x_valid_move = false;
 	bool is_y_valid_move = false;
@@ -255,9 +258,9 @@ uint32_t mesh_adaptive_routing(Flit* flit,
 	Mesh_ID x_next_dest_mesh_id;
 	Mesh_ID y_next_dest_mesh_id;
 
-	if (curr_mesh_id->x != final_dest_mesh_id->x) {
+	if (curr_mesh_id->x != final_dest_mesh_id.x) {
 		// route east
-		if (curr_mesh_id->x < final_dest_mesh_id->x) {
+		if (curr_mesh_id->x < final_dest_mesh_id.x) {
 			x_next_dest_mesh_id.x = curr_mesh_id->x + 1;
 			x_next_dest_mesh_id.y = curr_mesh_id->y;
 		}
@@ -269,9 +272,9 @@ uint32_t mesh_adaptive_routing(Flit* flit,
 		is_x_valid_move = true;
 	}
 
-	if (curr_mesh_id->y != final_dest_mesh_id->y) {
+	if (curr_mesh_id->y != final_dest_mesh_id.y) {
 		// route north
-		if (curr_mesh_id->y > final_dest_mesh_id->y) {
+		if (curr_mesh_id->y > final_dest_mesh_id.y) {
 			y_next_dest_mesh_id.x = curr_mesh_id->x;
 			y_next_dest_mesh_id.y = curr_mesh_id->y - 1;
 		}
@@ -293,8 +296,8 @@ uint32_t mesh_adaptive_routing(Flit* flit,
 	// if both x and y moves are valid, then choose the one with least traffic at next dest
 	if (is_x_valid_move && is_y_valid_move) {
 
-		bool is_x_unreserved_buffer = is_unreserved_buffer((void*)&x_next_dest_mesh_id, neighbor_to_io_channels_map);
-		bool is_y_unreserved_buffer = is_unreserved_buffer((void*)&y_next_dest_mesh_id, neighbor_to_io_channels_map);
+		bool is_x_unreserved_buffer = is_unreserved_buffer(flit, (void*)&x_next_dest_mesh_id, neighbor_to_io_channels_map);
+		bool is_y_unreserved_buffer = is_unreserved_buffer(flit, (void*)&y_next_dest_mesh_id, neighbor_to_io_channels_map);
 
 		// if both have unreserved buffers, then randomly pick one
 		if (is_x_unreserved_buffer && is_y_unreserved_buffer) {
@@ -330,7 +333,40 @@ uint32_t mesh_adaptive_routing(Flit* flit,
 
 	assert(next_router_id != (uint32_t)-1);
 
-	flit_info_to_router_id_cache->insert(flit_info, next_router_id);
 	// raise(SIGTRAP);
 	return next_router_id;
-}
\ No newline at end of file
+}
+
+// minimal adaptive, picks between the x and y ring steps by which has an unreserved buffer, preferring x like the mesh version
+uint32_t torus_adaptive_routing(Flit_Handle flit, 
+								uint32_t curr_router_id,
+								void* curr_network_id,
+								std::map<Router*, std::vector<IO_Channel*>*>* neighbor_to_io_channels_map) {
+
+	assert(get_flit_type(flit) == HEAD);
+
+	Mesh_Info* mesh_info = (Mesh_Info*)network_info;
+	Mesh_ID* curr_mesh_id = (Mesh_ID*)curr_network_id;
+	Mesh_ID final_dest_mesh_id;
+	convert_router_id_to_network_id(get_flit_dest(flit), (void*)&final_dest_mesh_id);
+
+	// check if flit needs to go to connected processor
+	if ((curr_mesh_id->x == final_dest_mesh_id.x) && (curr_mesh_id->y == final_dest_mesh_id.y)) return curr_router_id;
+
+	Mesh_ID x_next_dest_mesh_id = *curr_mesh_id;
+	Mesh_ID y_next_dest_mesh_id = *curr_mesh_id;
+	bool is_x_valid_move = curr_mesh_id->x != final_dest_mesh_id.x;
+	bool is_y_valid_move = curr_mesh_id->y != final_dest_mesh_id.y;
+	if (is_x_valid_move) x_next_dest_mesh_id.x = get_ring_step(curr_mesh_id->x, final_dest_mesh_id.x, mesh_info->num_cols);
+	if (is_y_valid_move) y_next_dest_mesh_id.y = get_ring_step(curr_mesh_id->y, final_dest_mesh_id.y, mesh_info->num_rows);
+
+	// only switch to y if x has nowhere to go and y does
+	if (is_x_valid_move && is_y_valid_move) {
+		bool is_x_unreserved_buffer = is_unreserved_buffer(flit, (void*)&x_next_dest_mesh_id, neighbor_to_io_channels_map);
+		bool is_y_unreserved_buffer = is_unreserved_buffer(flit, (void*)&y_next_dest_mesh_id, neighbor_to_io_channels_map);
+		if (!is_x_unreserved_buffer && is_y_unreserved_buffer) return convert_network_id_to_router_id((void*)&y_next_dest_mesh_id);
+		return convert_network_id_to_router_id((void*)&x_next_dest_mesh_id);
+	}
+	else if (is_x_valid_move) return convert_network_id_to_router_id((void*)&x_next_dest_mesh_id);
+	return convert_network_id_to_router_id((void*)&y_next_dest_mesh_id);
+}
@@ -0,0 +1,81 @@
+import subprocess
+import shutil
+import os
+import sys
+
+# usage: python3 src/saturation_search.py <test path> [num threads] [Bernoulli|Poisson] [num steps]
+# bisects the injection rate (messages per processor per clock cycle) of the test's config.txt for the
+# point where average latency grows past latency_factor times the zero load latency
+
+latency_factor = 3.0
+zero_load_rate = 0.001
+injection_keys = ["Injection Process:", "Injection Rate:"]
+
+def read_config(config_path):
+	config_lines = []
+	with open(config_path, "r") as config_file:
+		for line in config_file:
+			line = line.rstrip("\r\n")
+			if line == "" or any(line.startswith(key) for key in injection_keys):
+				continue
+			config_lines.append(line)
+	return config_lines
+
+def run_rate(config_lines, search_path, num_threads, injection_process, injection_rate):
+	rate_path = os.path.join(search_path, "rate_" + ("%.6f" % injection_rate))
+	os.makedirs(rate_path, exist_ok=True)
+	with open(os.path.join(rate_path, "config.txt"), "w") as config_file:
+		for line in config_lines:
+			config_file.write(line + "\n")
+		config_file.write("Injection Process: " + injection_process + "\n")
+		config_file.write("Injection Rate: " + str(injection_rate) + "\n")
+
+	result = subprocess.run(["./main", "-d", "-t", str(num_threads), "-p", rate_path + "/"], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+	# a deadlocked network is as saturated as it gets
+	if result.returncode == 2:
+		print("%-15.6f%-15s" % (injection_rate, "deadlock"))
+		return float("inf")
+	latency = None
+	throughput = None
+	for line in result.stdout.decode('utf-8').split("\n"):
+		if line.startswith("Average Message Latency in Clock Cycles:"):
+			latency = float(line.split(":")[1])
+		if line.startswith("Average Throughput in Messages/Clock Cycles:"):
+			throughput = float(line.split(":")[1])
+	if latency is None:
+		sys.stderr.write(result.stderr.decode('utf-8'))
+		sys.exit("simulation failed at injection rate " + str(injection_rate))
+	print("%-15.6f%-15.3f%-15.6f" % (injection_rate, latency, throughput))
+	return latency
+
+if __name__ == "__main__":
+	test_path = sys.argv[1]
+	num_threads = sys.argv[2] if len(sys.argv) > 2 else 1
+	injection_process = sys.argv[3] if len(sys.argv) > 3 else "Bernoulli"
+	num_steps = int(sys.argv[4]) if len(sys.argv) > 4 else 10
+
+	config_lines = read_config(os.path.join(test_path, "config.txt"))
+	search_path = os.path.join(test_path, "saturation_search")
+	if os.path.isdir(search_path):
+		shutil.rmtree(search_path)
+
+	subprocess.run(["make", "main"])
+	print("%-15s%-15s%-15s" % ("Rate", "Latency", "Throughput"))
+	zero_load_latency = run_rate(config_lines, search_path, num_threads, injection_process, zero_load_rate)
+	saturation_latency = latency_factor * zero_load_latency
+
+	# lower rate is known to be below saturation, upper rate is known to be at or above it
+	lower_rate = zero_load_rate
+	upper_rate = 1.0
+	if run_rate(config_lines, search_path, num_threads, injection_process, upper_rate) < saturation_latency:
+		print("Network Does Not Saturate Below Injection Rate " + str(upper_rate))
+		sys.exit(0)
+	for i in range(num_steps):
+		rate = (lower_rate + upper_rate) / 2
+		if run_rate(config_lines, search_path, num_threads, injection_process, rate) < saturation_latency:
+			lower_rate = rate
+		else:
+			upper_rate = rate
+
+	print("Zero Load Latency in Clock Cycles: " + str(zero_load_latency))
+	print("Saturation Injection Rate in Messages/Processor/Clock Cycle: " + str(lower_rate))
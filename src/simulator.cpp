@@ -2,55 +2,156 @@
 #include <cassert>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <signal.h>
 #include <omp.h>
-#include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <math.h>
+#include <sys/mman.h>
 
 #include "simulator.h"
 #include "network.h"
 #include "message_generator.h"
 #include "config_parser.h"
+#include "worker_pool.h"
+#include "flit.h"
+#include "completion_tracker.h"
+#include "over_time_recorder.h"
+#include "latency_histogram.h"
+#include "heatmap_writer.h"
+#include "deadlock_detector.h"
+#include "checkpoint.h"
 
 uint32_t packet_width;
 uint32_t num_data_flits_per_packet;
 
 uint32_t global_clock;
-Message_Transmission_Info** global_message_transmission_info;
+Message_Transmission_Info* global_message_transmission_info;
+Completion_Tracker* global_completion_tracker;
 
-Simulator::Simulator(std::string test_path, bool is_verbose) {
+// bytes mapped for the message transmission infos, never 0 so an empty trace still gets a mapping
+static size_t get_message_info_size (uint32_t num_messages) {
+	return std::max(num_messages, (uint32_t)1) * sizeof(Message_Transmission_Info);
+}
+
+// the parameters that shape the built network, a config that changes any of them needs a new one
+static const char* network_parameter_keys[] = {
+	"Network Type",
+	"Number of Processors",
+	"Number of Routers",
+	"Router Buffer Capacity",
+	"Number of Virtual Channels",
+	"Packet Width",
+	"Number of Data Flits Per Packet",
+	"Routing Algorithm",
+	"Flow Control Algorithm",
+	"Flow Control Granularity"
+};
+
+Simulator::Simulator(std::string test_path, bool is_verbose, SIMULATION_ENGINE engine, uint32_t first_cpu) {
 	this->is_verbose = is_verbose;
+	this->engine = engine;
+	this->first_cpu = first_cpu;
+	this->num_threads = omp_get_num_threads();
+
+	this->network = NULL;
+	this->worker_pool = NULL;
+	this->thread_over_time_metrics = NULL;
+	this->network_signature = "";
+
+	// nothing from a previous run to free yet
+	this->config_parser = NULL;
+	this->message_generator = NULL;
+	this->trace_reader = NULL;
+	this->stats_writer = NULL;
+	this->over_time_recorder = NULL;
+	this->heatmap_writer = NULL;
+	this->deadlock_detector = NULL;
+	this->checkpoint = NULL;
+	this->latency_histogram_set = NULL;
+	global_message_transmission_info = NULL;
+	global_completion_tracker = NULL;
+
+	this->reset(test_path);
+}
+
+bool Simulator::is_network_parameter (std::string key) {
+	for (uint32_t i=0; i < sizeof(network_parameter_keys) / sizeof(network_parameter_keys[0]); i++) {
+		if (key.compare(network_parameter_keys[i]) == 0) return true;
+	}
+	// these two size the processor input buffers
+	return key.compare("Upper Message Size") == 0 || key.compare("Trace File") == 0;
+}
+
+// points the simulator at another test directory. the network and worker pool stay, setup resets them for the next run,
+// everything else the previous run allocated is freed here
+void Simulator::reset (std::string test_path) {
+	delete this->config_parser;
+	delete this->message_generator;
+	delete this->trace_reader;
+	delete this->stats_writer;
+	delete this->over_time_recorder;
+	delete this->heatmap_writer;
+	delete this->deadlock_detector;
+	delete this->checkpoint;
+	delete this->latency_histogram_set;
+	if (global_message_transmission_info != NULL) munmap(global_message_transmission_info, get_message_info_size(this->num_messages));
+	global_message_transmission_info = NULL;
+	delete global_completion_tracker;
+	global_completion_tracker = NULL;
 
 	this->test_path = test_path;
 	this->config_file_path = test_path + "config.txt";
-	this->tx_stats_path = test_path + "tx_stats.txt";
-	this->rx_stats_path = test_path + "rx_stats.txt";
-	this->stalls_stats_path = test_path + "stalls_stats.txt";
-	this->buffers_stats_path = test_path + "buffers_stats.txt";
-	this->transmissions_stats_path = test_path + "transmissions_stats.txt";
-	this->aggregate_stats_path = test_path + "aggregate_stats.txt";
+	this->stats_path = test_path + "stats.bin";
+	this->heatmap_path = test_path + "heatmap.bin";
 
-	this->network = NULL;
 	this->message_generator = NULL;
+	this->trace_reader = NULL;
+	this->num_messages = 0;
 	this->config_parser = NULL;
 	this->is_simulation_finished = false;
-	this->num_threads = omp_get_num_threads();
 
 	this->total_message_latency = 0;
+	this->total_message_queueing_delay = 0;
 	this->total_message_distance = 0.0;
 	this->total_message_size = 0;
 	this->avg_message_latency = 0.0;
+	this->avg_message_queueing_delay = 0.0;
 	this->avg_message_distance = 0.0;
 	this->avg_message_size = 0;
 	this->avg_message_throughput = 0.0;
 	this->avg_message_speed = 0.0;
-	this->tx_flits_over_time_vec = new std::vector<uint32_t>;
-	this->rx_flits_over_time_vec = new std::vector<uint32_t>;
-	this->stalls_over_time_vec = new std::vector<uint32_t>;
-	this->buffers_efficiency_over_time_vec = new std::vector<float>;
-
-	this->num_flits_in_network = -1;
-	this->sample_rate = 1000;
+	this->latency_histogram_set = NULL;
+	this->num_latency_regions = 0;
+	this->stats_writer = NULL;
+	this->over_time_recorder = NULL;
+	this->sample_interval = 1;
+	this->num_cycles_since_sample = 0;
+	memset(&this->last_sample_metrics, 0, sizeof(Over_Time_Metrics));
+	this->is_sample_due = false;
+	this->is_thread_metrics_fresh = false;
+	this->heatmap_writer = NULL;
+	this->heatmap_interval = 0;
+	this->next_heatmap_cycle = (uint32_t)-1;
+	this->last_heatmap_cycle = (uint32_t)-1;
+
+	this->deadlock_detector = NULL;
+	this->num_flit_moves_at_check = 0;
+	this->num_cycles_since_check = 0;
+	this->check_interval = 1000;
+	this->is_deadlocked = false;
+
+	this->checkpoint = NULL;
+	this->checkpoint_interval = 0;
+	this->next_checkpoint_cycle = (uint32_t)-1;
+	this->first_cycle = 0;
+
+	this->warmup_cycles = 0;
+	this->measurement_cycles = 0;
+	this->drain_cycles = 0;
+	this->measurement_end = (uint32_t)-1;
+	this->num_measured_messages = 0;
 }
 
 void Simulator::setup() {
@@ -78,6 +179,21 @@ void Simulator::setup() {
 	this->config_parser->initialize_parameter_key("Upper Message Size");
 	this->config_parser->initialize_parameter_key("Message Size Distribution");
 	this->config_parser->initialize_parameter_key("Message Node Distribution");
+	this->config_parser->initialize_parameter_key("Injection Process", "Batch");
+	this->config_parser->initialize_parameter_key("Injection Rate", "0");
+	this->config_parser->initialize_parameter_key("Hotspot Fraction", "0.5");
+	this->config_parser->initialize_parameter_key("Hotspot Nodes", "0");
+	this->config_parser->initialize_parameter_key("Trace File", "");
+	this->config_parser->initialize_parameter_key("Stats Sample Interval", "1");
+	this->config_parser->initialize_parameter_key("Stats Window Size", "1");
+	this->config_parser->initialize_parameter_key("Stats Window Ring Size", "0");
+	this->config_parser->initialize_parameter_key("Latency Regions", "4");
+	this->config_parser->initialize_parameter_key("Heatmap Interval", "0");
+	this->config_parser->initialize_parameter_key("Deadlock Check Interval", "1000");
+	this->config_parser->initialize_parameter_key("Checkpoint Interval", "0");
+	this->config_parser->initialize_parameter_key("Warmup Cycles", "0");
+	this->config_parser->initialize_parameter_key("Measurement Cycles", "0");
+	this->config_parser->initialize_parameter_key("Drain Cycles", "0");
 
 	// read config file
 	this->config_parser->parse_config_file(this->config_file_path);
@@ -85,17 +201,51 @@ void Simulator::setup() {
 	this->config_parser->print();
 	std::cout << std::endl;
 
+	// over time stats are written out as they are recorded
+	this->stats_writer = new Stats_Writer(this->stats_path, this->config_file_path);
+	this->sample_interval = this->config_parser->get_int_parameter_value("Stats Sample Interval");
+	uint32_t window_size = this->config_parser->get_int_parameter_value("Stats Window Size");
+	uint32_t window_ring_size = this->config_parser->get_int_parameter_value("Stats Window Ring Size");
+	this->num_latency_regions = this->config_parser->get_int_parameter_value("Latency Regions");
+	this->heatmap_interval = this->config_parser->get_int_parameter_value("Heatmap Interval");
+	this->check_interval = this->config_parser->get_int_parameter_value("Deadlock Check Interval");
+	if (this->heatmap_interval > 0) this->next_heatmap_cycle = this->heatmap_interval;
+	this->checkpoint_interval = this->config_parser->get_int_parameter_value("Checkpoint Interval");
+	if (this->checkpoint_interval > 0) this->next_checkpoint_cycle = this->checkpoint_interval;
+	this->warmup_cycles = this->config_parser->get_int_parameter_value("Warmup Cycles");
+	this->measurement_cycles = this->config_parser->get_int_parameter_value("Measurement Cycles");
+	this->drain_cycles = this->config_parser->get_int_parameter_value("Drain Cycles");
+	if (this->measurement_cycles > 0) this->measurement_end = this->warmup_cycles + this->measurement_cycles;
+	assert(this->sample_interval > 0);
+	this->over_time_recorder = new Over_Time_Recorder(this->stats_writer, window_size, window_ring_size);
+
 	// initialize global vars
 	packet_width = this->config_parser->get_int_parameter_value("Packet Width");
 	num_data_flits_per_packet = this->config_parser->get_int_parameter_value("Number of Data Flits Per Packet");
+	if (this->network == NULL) init_flit_table(num_data_flits_per_packet);
 
 	// get message generator parameters
 	uint32_t num_messages = this->config_parser->get_int_parameter_value("Number of Messages");
 	uint32_t num_processors = this->config_parser->get_int_parameter_value("Number of Processors");
 	uint32_t lower_message_size = this->config_parser->get_int_parameter_value("Lower Message Size");
 	uint32_t upper_message_size = this->config_parser->get_int_parameter_value("Upper Message Size");
+	std::string trace_file_str = this->config_parser->get_string_parameter_value("Trace File");
 	std::string message_size_distribution_str = this->config_parser->get_string_parameter_value("Message Size Distribution");
 	std::string message_node_distribution_str = this->config_parser->get_string_parameter_value("Message Node Distribution");
+	std::string message_injection_process_str = this->config_parser->get_string_parameter_value("Injection Process");
+	double injection_rate = this->config_parser->get_float_parameter_value("Injection Rate");
+	double hotspot_fraction = this->config_parser->get_float_parameter_value("Hotspot Fraction");
+	std::string hotspot_nodes_str = this->config_parser->get_string_parameter_value("Hotspot Nodes");
+
+	// a trace replaces the generated messages, relative paths are inside the test directory
+	if (trace_file_str.compare("") != 0) {
+		if (trace_file_str[0] != '/') trace_file_str = this->test_path + trace_file_str;
+		this->trace_reader = new Trace_Reader(trace_file_str);
+		assert(this->trace_reader->num_processors <= num_processors);
+		num_messages = this->trace_reader->num_records;
+		upper_message_size = std::max(upper_message_size, this->trace_reader->max_message_size);
+	}
+	this->num_messages = num_messages;
 
 	// initialize message size distribution
 	MESSAGE_SIZE_DISTRIBUTION message_size_distribution;
@@ -119,27 +269,91 @@ void Simulator::setup() {
 	else if (message_node_distribution_str.compare("Uniform") == 0) {
 		message_node_distribution = NODE_UNIFORM;
 	}
+	else if (message_node_distribution_str.compare("Transpose") == 0) {
+		message_node_distribution = NODE_TRANSPOSE;
+	}
+	else if (message_node_distribution_str.compare("Bit Complement") == 0) {
+		message_node_distribution = NODE_BIT_COMPLEMENT;
+	}
+	else if (message_node_distribution_str.compare("Bit Reverse") == 0) {
+		message_node_distribution = NODE_BIT_REVERSE;
+	}
+	else if (message_node_distribution_str.compare("Shuffle") == 0) {
+		message_node_distribution = NODE_SHUFFLE;
+	}
+	else if (message_node_distribution_str.compare("Tornado") == 0) {
+		message_node_distribution = NODE_TORNADO;
+	}
+	else if (message_node_distribution_str.compare("Nearest Neighbor") == 0) {
+		message_node_distribution = NODE_NEIGHBOR;
+	}
+	else if (message_node_distribution_str.compare("Hotspot") == 0) {
+		message_node_distribution = NODE_HOTSPOT;
+	}
 	// should never come here
 	else assert(false);
 
-	// initialize global message transmission info
-	global_message_transmission_info = new Message_Transmission_Info*[num_messages];
-	for (uint32_t i=0; i < num_messages; i++) {
-		Message_Transmission_Info* message_transmission_info = new Message_Transmission_Info;
-		message_transmission_info->tx_processor_id = 0;
-		message_transmission_info->tx_time = -1;
-		message_transmission_info->rx_processor_id = 0;
-		message_transmission_info->rx_time = -1;
-		global_message_transmission_info[i] = message_transmission_info;
+	// comma separated processor ids that hotspot traffic is sent to
+	std::vector<uint32_t>* hotspot_vec = new std::vector<uint32_t>;
+	size_t hotspot_begin = 0;
+	while (hotspot_begin < hotspot_nodes_str.size()) {
+		size_t hotspot_end = hotspot_nodes_str.find_first_of(",", hotspot_begin);
+		if (hotspot_end == std::string::npos) hotspot_end = hotspot_nodes_str.size();
+		uint32_t hotspot = (uint32_t)stoi(hotspot_nodes_str.substr(hotspot_begin, hotspot_end - hotspot_begin));
+		assert(hotspot < num_processors);
+		hotspot_vec->push_back(hotspot);
+		hotspot_begin = hotspot_end + 1;
 	}
+	assert(hotspot_vec->size() > 0);
+
+	// initialize message injection process
+	MESSAGE_INJECTION_PROCESS message_injection_process;
+	if (message_injection_process_str.compare("Batch") == 0) {
+		message_injection_process = INJECTION_BATCH;
+	}
+	else if (message_injection_process_str.compare("Bernoulli") == 0) {
+		message_injection_process = INJECTION_BERNOULLI;
+	}
+	else if (message_injection_process_str.compare("Poisson") == 0) {
+		message_injection_process = INJECTION_POISSON;
+	}
+	// should never come here
+	else {
+		raise(SIGTRAP);
+		assert(false);
+	}
+
+	// one flat array indexed by message id. the mapping is zero filled on first touch, so an entry only takes memory
+	// once the message constructor fills it in, which for a trace is when its record is released
+	global_message_transmission_info = (Message_Transmission_Info*)mmap(NULL, get_message_info_size(num_messages), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	assert(global_message_transmission_info != MAP_FAILED);
+
+	// every message is outstanding until its last flit is received, and starts out untagged
+	global_completion_tracker = new Completion_Tracker(NUM_MEASUREMENT_BATCHES);
+	global_completion_tracker->set_measurement_window(this->warmup_cycles, this->measurement_end);
+	global_completion_tracker->add_messages(UNTAGGED_BATCH, num_messages);
 
 	// initialize message generator
-	this->message_generator	= new Message_Generator(num_messages,
-					 				  				num_processors,
-					  				  				lower_message_size, 
-					  				  				upper_message_size, 
-					  				  				message_size_distribution,
-					  				  				message_node_distribution);
+	if (this->trace_reader == NULL) {
+		this->message_generator	= new Message_Generator(num_messages,
+						 				  				num_processors,
+						  				  				lower_message_size, 
+						  				  				upper_message_size, 
+						  				  				message_size_distribution,
+						  				  				message_node_distribution,
+						  				  				message_injection_process,
+						  				  				injection_rate,
+						  				  				hotspot_fraction,
+						  				  				hotspot_vec);
+	}
+	else delete hotspot_vec;
+
+	// open loop messages know their creation cycle up front, the rest are tagged when they are created
+	if (this->message_generator != NULL) {
+		for (uint32_t i=0; i < num_messages; i++) {
+			if (global_message_transmission_info[i].creation_time >= 0) global_completion_tracker->record_created(&global_message_transmission_info[i]);
+		}
+	}
 
 	// get network parameters
 	std::string network_type = this->config_parser->get_string_parameter_value("Network Type");
@@ -162,6 +376,12 @@ void Simulator::setup() {
 	else if (routing_algo_str.compare("Mesh Adaptive") == 0) {
 		routing_func = &mesh_adaptive_routing;
 	}
+	else if (routing_algo_str.compare("Torus XY") == 0) {
+		routing_func = &torus_xy_routing;
+	}
+	else if (routing_algo_str.compare("Torus Adaptive") == 0) {
+		routing_func = &torus_adaptive_routing;
+	}
 	// should never come here
 	else assert(false);
 
@@ -187,10 +407,49 @@ void Simulator::setup() {
 	// should never come here
 	else assert(false);
 
+	// the torus virtual channel classes assume xy order and the shorter way around each ring
+	bool is_torus_routing = routing_algo_str.compare(0, 5, "Torus") == 0;
+	if (is_torus_routing != (network_type.compare("Torus") == 0)) {
+		fprintf(stderr, "Routing Algorithm %s Does Not Fit Network Type %s\n", routing_algo_str.c_str(), network_type.c_str());
+		exit(1);
+	}
+	if (is_torus_routing && ((uint32_t)sqrt(num_processors) < 3 || num_virtual_channels < 2)) {
+		fprintf(stderr, "A Torus Needs at Least 3x3 Routers and 2 Virtual Channels for its Dateline Classes\n");
+		exit(1);
+	}
+	// the head of a packet is only forwarded once its tail is in the same buffer, which a smaller buffer never holds
+	if (flow_control_func == &store_forward_flow_control && router_buffer_capacity < num_data_flits_per_packet + 2) {
+		fprintf(stderr, "Store Forward Flow Control Needs Router Buffers That Hold a Whole Packet of %d Flits\n", num_data_flits_per_packet + 2);
+		exit(1);
+	}
+	// a locked channel is only freed once the packet is through, which a blocked packet never is unless one buffer holds it whole
+	if (is_torus_routing && flow_control_granularity == PACKET && router_buffer_capacity < num_data_flits_per_packet + 2) {
+		fprintf(stderr, "Packet Flow Control on a Torus Needs Router Buffers That Hold a Whole Packet of %d Flits\n", num_data_flits_per_packet + 2);
+		exit(1);
+	}
+
+	// a network built by an earlier run is reset in place, the topology and its buffers stay allocated
+	std::string network_signature = std::to_string(input_buffer_capacity);
+	for (uint32_t i=0; i < sizeof(network_parameter_keys) / sizeof(network_parameter_keys[0]); i++) {
+		network_signature += "\n" + this->config_parser->get_string_parameter_value(network_parameter_keys[i]);
+	}
+	if (this->network != NULL && network_signature.compare(this->network_signature) != 0) {
+		fprintf(stderr, "Config %s Does Not Match the Network of the Previous Run\n", this->config_file_path.c_str());
+		exit(1);
+	}
+	this->network_signature = network_signature;
 
+	// the worker pool is up before the network so that its threads can build their own part of it
+	if (this->engine == WORKER_POOL && this->worker_pool == NULL) {
+		this->worker_pool = new Worker_Pool(omp_get_max_threads(), this->first_cpu);
+		this->thread_over_time_metrics = new Over_Time_Metrics[this->worker_pool->num_threads];
+	}
 
 	// initialize network
-	if (network_type.compare("Mesh") == 0) {
+	if (this->network != NULL) {
+		this->network->reset();
+	}
+	else if (network_type.compare("Mesh") == 0) {
 		this->network = new Mesh_Network(num_processors, 
 										 num_routers, 
 										 input_buffer_capacity,
@@ -198,35 +457,168 @@ void Simulator::setup() {
 										 num_virtual_channels,
 										 routing_func, 
 										 flow_control_func, 
-										 flow_control_granularity);
+										 flow_control_granularity,
+										 this->worker_pool);
+	}
+	else if (network_type.compare("Torus") == 0) {
+		this->network = new Torus_Network(num_processors, 
+										  num_routers, 
+										  input_buffer_capacity,
+										  router_buffer_capacity,
+										  num_virtual_channels,
+										  routing_func, 
+										  flow_control_func, 
+										  flow_control_granularity,
+										  this->worker_pool);
 	}
 	// should never come here
 	else assert(false);
 
-	// transfer messages into processor data structures
+	// transfer messages into processor data structures, trace messages are handed out as the clock reaches them
 	for (uint32_t i=0; i < num_processors; i++) {
-		this->network->processor_lst[i]->init_tx_message_vec(this->message_generator->get_tx_message_data_vec(i));
-		this->network->processor_lst[i]->init_rx_message_map(this->message_generator->get_rx_message_data_map(i));
+		if (this->trace_reader != NULL) this->network->processor_lst[i]->init_tx_message_queue(new std::deque<Message>);
+		else this->network->processor_lst[i]->init_tx_message_queue(this->message_generator->get_tx_message_queue(i));
+		this->network->processor_lst[i]->init_latency_histogram_set(new Latency_Histogram_Set(num_processors, this->num_latency_regions));
 	}
+	this->release_trace_messages();
+
+	// initialize simulation engine once processors know which messages they have to send
+	this->network->init_simulation_engine(this->engine);
+	this->heatmap_writer = this->network->create_heatmap_writer(this->heatmap_path);
+	this->deadlock_detector = new Deadlock_Detector(this->network);
+	this->checkpoint = new Checkpoint(this->network, this->trace_reader, num_messages);
 
 	printf("Finished Simulation Setup!!!\n\n");
 
 }
 
+// a deadlocked run stops early so the stats of the messages that did get through are still written. once the
+// measurement window has closed no more messages get tagged, so the run only drains until the tagged ones are in
 void Simulator::update_simulation_status () {
-	for (uint32_t i=0; i < this->message_generator->num_messages; i++) {
-		int rx_time = global_message_transmission_info[i]->rx_time;
-		if (rx_time < 0) return;
+	bool is_drained = false;
+	if (global_clock >= this->measurement_end) {
+		is_drained = global_completion_tracker->is_batch_delivered(TAGGED_BATCH);
+		if (this->drain_cycles > 0 && global_clock - this->measurement_end >= this->drain_cycles) is_drained = true;
+	}
+	this->is_simulation_finished = this->is_deadlocked || is_drained || global_completion_tracker->is_all_delivered();
+}
+
+// delivered and created inside the measurement window
+bool Simulator::is_measured_message (Message_Transmission_Info* message_transmission_info) {
+	return message_transmission_info->rx_time >= 0 && message_transmission_info->batch_id == TAGGED_BATCH;
+}
+
+// only builds the wait-for graph if messages are in flight and no flit has moved since the previous check. a stall
+// without stuck virtual channels is only reported, every flit in it waits on something that can still move
+void Simulator::check_deadlock () {
+	uint64_t num_flit_moves = this->deadlock_detector->count_flit_moves();
+	bool is_stuck = num_flit_moves == this->num_flit_moves_at_check && global_completion_tracker->get_num_in_flight() > 0;
+	this->num_flit_moves_at_check = num_flit_moves;
+	if (!is_stuck) return;
+
+	if (this->deadlock_detector->detect() == 0) {
+		fprintf(stderr, "No Flit Moved Since the Last Deadlock Check at Clock Cycle %d but No Virtual Channel Is Deadlocked, Simulation Continues\n", global_clock);
+		return;
+	}
+	this->deadlock_detector->report(stderr);
+	this->is_deadlocked = true;
+}
+
+bool Simulator::has_deadlocked () {return this->is_deadlocked;}
+
+// taken at the start of a cycle, once the previous one has been fully accounted for
+void Simulator::update_checkpoint () {
+	if (global_clock < this->next_checkpoint_cycle) return;
+	std::string checkpoint_file_path = this->test_path + "checkpoint_" + std::to_string(global_clock) + ".bin";
+
+	Checkpoint_Simulator_State state;
+	memset(&state, 0, sizeof(Checkpoint_Simulator_State));
+	state.num_cycles_since_sample = this->num_cycles_since_sample;
+	state.last_tx_flits = this->last_sample_metrics.tx_flits;
+	state.last_rx_flits = this->last_sample_metrics.rx_flits;
+	state.last_num_stalls = this->last_sample_metrics.num_stalls;
+	state.last_buffers_space_occupied = this->last_sample_metrics.buffers_space_occupied;
+	state.last_buffers_space_total = this->last_sample_metrics.buffers_space_total;
+	state.next_heatmap_cycle = this->next_heatmap_cycle;
+	state.last_heatmap_cycle = this->last_heatmap_cycle;
+	state.num_cycles_since_check = this->num_cycles_since_check;
+	state.num_flit_moves_at_check = this->num_flit_moves_at_check;
+	this->checkpoint->save(checkpoint_file_path, &state);
+	if (this->is_verbose) printf("Saved Checkpoint %s\n", checkpoint_file_path.c_str());
+
+	this->next_checkpoint_cycle = (global_clock / this->checkpoint_interval + 1) * this->checkpoint_interval;
+}
+
+// over time stats and heatmap snapshots of a restored run start where the checkpoint was taken,
+// the latency histograms are rebuilt from the messages delivered before it
+void Simulator::restore_checkpoint (std::string checkpoint_file_path) {
+	Checkpoint_Simulator_State state;
+	this->checkpoint->restore(checkpoint_file_path, &state);
+	global_completion_tracker->set_measurement_window(this->warmup_cycles, this->measurement_end);
+	this->num_cycles_since_sample = state.num_cycles_since_sample;
+	this->last_sample_metrics.tx_flits = state.last_tx_flits;
+	this->last_sample_metrics.rx_flits = state.last_rx_flits;
+	this->last_sample_metrics.num_stalls = state.last_num_stalls;
+	this->last_sample_metrics.buffers_space_occupied = state.last_buffers_space_occupied;
+	this->last_sample_metrics.buffers_space_total = state.last_buffers_space_total;
+	this->next_heatmap_cycle = state.next_heatmap_cycle;
+	this->last_heatmap_cycle = state.last_heatmap_cycle;
+	this->num_cycles_since_check = state.num_cycles_since_check;
+	this->num_flit_moves_at_check = state.num_flit_moves_at_check;
+	this->first_cycle = global_clock - this->num_cycles_since_sample;
+	if (this->checkpoint_interval > 0) this->next_checkpoint_cycle = (global_clock / this->checkpoint_interval + 1) * this->checkpoint_interval;
+
+	for (uint32_t i=0; i < this->network->num_processors; i++) {
+		Processor* processor = this->network->processor_lst[i];
+		Latency_Histogram_Set* latency_histogram_set = new Latency_Histogram_Set(this->network->num_processors, this->num_latency_regions);
+		for (uint32_t j=0; j < processor->received_messages_vec->size(); j++) {
+			Message_Transmission_Info* message_transmission_info = &global_message_transmission_info[(*processor->received_messages_vec)[j]];
+			if (message_transmission_info->batch_id != TAGGED_BATCH) continue;
+			latency_histogram_set->record(message_transmission_info->latency,
+										  (uint32_t)message_transmission_info->avg_packet_distance,
+										  message_transmission_info->tx_processor_id,
+										  message_transmission_info->rx_processor_id);
+		}
+		processor->init_latency_histogram_set(latency_histogram_set);
 	}
-	this->is_simulation_finished = true;
+
+	printf("Restored Checkpoint %s at Clock Cycle %d\n\n", checkpoint_file_path.c_str(), global_clock);
 }
 
+// only every sample_interval'th cycle pays for the reduction over the network
 void Simulator::update_over_time_metrics () {
+	this->num_cycles_since_sample++;
+	if (this->num_cycles_since_sample < this->sample_interval) return;
+	this->sample_over_time_metrics();
+}
+
+// the worker pool threads sum their partitions on sample cycles, off schedule samples sum them here,
+// the other engines go over the whole network
+void Simulator::sample_over_time_metrics () {
+	if (this->engine == WORKER_POOL) {
+		if (!this->is_thread_metrics_fresh) {
+			for (uint32_t i=0; i < this->worker_pool->num_threads; i++) {
+				this->network->sum_partition_metrics(i, &this->thread_over_time_metrics[i]);
+			}
+		}
+		Over_Time_Metrics metrics = this->thread_over_time_metrics[0];
+		for (uint32_t i=1; i < this->worker_pool->num_threads; i++) {
+			metrics.tx_flits += this->thread_over_time_metrics[i].tx_flits;
+			metrics.rx_flits += this->thread_over_time_metrics[i].rx_flits;
+			metrics.num_stalls += this->thread_over_time_metrics[i].num_stalls;
+			metrics.buffers_space_occupied += this->thread_over_time_metrics[i].buffers_space_occupied;
+			metrics.buffers_space_total += this->thread_over_time_metrics[i].buffers_space_total;
+		}
+		this->record_over_time_metrics(&metrics);
+		return;
+	}
+
 	uint32_t sum_tx_flits = 0;
 	uint32_t sum_rx_flits = 0;
 	uint32_t sum_num_stalls = 0;
 	uint32_t sum_buffers_space_occupied = 0;
 	uint32_t sum_buffers_space_total = 0;
+	Over_Time_Metrics metrics;
 
 	#pragma omp parallel 
 	{
@@ -239,14 +631,14 @@ void Simulator::update_over_time_metrics () {
 		#pragma omp for schedule(static) nowait
 		for (uint32_t i=0; i < this->network->num_processors; i++) {
 			Processor* processor = this->network->processor_lst[i];
-			if (processor->did_transmit_message()) thread_tx_flits += 1;
-			if (processor->did_receive_message()) thread_rx_flits += 1;
+			thread_tx_flits += processor->num_flits_transmitted;
+			thread_rx_flits += processor->num_flits_received;
 		}
 
 		#pragma omp for schedule(static) nowait
 		for (uint32_t i=0; i < this->network->num_routers; i++) {
 			Router* router = this->network->router_lst[i];
-			thread_num_stalls += router->get_num_stalls();
+			thread_num_stalls += router->get_total_num_stalls();
 			thread_buffers_space_occupied += router->get_buffer_space_occupied();
 			thread_buffers_space_total += router->get_buffer_space_total();
 		}
@@ -263,64 +655,181 @@ void Simulator::update_over_time_metrics () {
 		sum_buffers_space_total += thread_buffers_space_total;
 	}
 
+	metrics.tx_flits = sum_tx_flits;
+	metrics.rx_flits = sum_rx_flits;
+	metrics.num_stalls = sum_num_stalls;
+	metrics.buffers_space_occupied = sum_buffers_space_occupied;
+	metrics.buffers_space_total = sum_buffers_space_total;
+	this->record_over_time_metrics(&metrics);
+}
+
+// turns the running totals into counts since the previous sample
+void Simulator::record_over_time_metrics (Over_Time_Metrics* metrics) {
+	uint32_t num_cycles = this->num_cycles_since_sample;
+	uint32_t sum_tx_flits = metrics->tx_flits - this->last_sample_metrics.tx_flits;
+	uint32_t sum_rx_flits = metrics->rx_flits - this->last_sample_metrics.rx_flits;
+	uint32_t sum_num_stalls = metrics->num_stalls - this->last_sample_metrics.num_stalls;
+	uint32_t sum_buffers_space_occupied = metrics->buffers_space_occupied;
+	uint32_t sum_buffers_space_total = metrics->buffers_space_total;
+	this->last_sample_metrics = *metrics;
+	this->num_cycles_since_sample = 0;
+
 	// printf("Num Transmitted %d\n", sum_tx_flits);
 	// printf("Num Received %d\n", sum_rx_flits);
 	if (this->is_verbose) printf("Num Flits in Network %d\n", sum_buffers_space_occupied);
 	// flits = sum_buffers_space_occupied;
 	// printf("\n");
 
-	// deadlock check
-	if (global_clock % this->sample_rate == 0) {
-		if (this->num_flits_in_network == (int)sum_buffers_space_occupied) {
-			assert(false);
-		}
-		else {
-			this->num_flits_in_network = sum_buffers_space_occupied;
-		}
+	this->over_time_recorder->add_sample(num_cycles, sum_tx_flits, sum_rx_flits, sum_num_stalls, sum_buffers_space_occupied, sum_buffers_space_total);
+
+	this->num_cycles_since_check += num_cycles;
+	if (this->num_cycles_since_check >= this->check_interval) {
+		this->num_cycles_since_check = 0;
+		this->check_deadlock();
+	}
+}
+
+// counters are cumulative, so after a fast forward past several snapshot cycles one snapshot covers them
+void Simulator::update_heatmap () {
+	if (global_clock < this->next_heatmap_cycle) return;
+	if (this->heatmap_writer != NULL) this->network->write_heatmap_snapshot(this->heatmap_writer);
+	this->last_heatmap_cycle = global_clock;
+	this->next_heatmap_cycle = (global_clock / this->heatmap_interval + 1) * this->heatmap_interval;
+}
+
+// if no flits are in flight, jump the global clock straight to the next message release
+void Simulator::fast_forward_quiescent_cycles () {
+	if (global_completion_tracker->get_num_in_flight() != 0) return;
+
+	uint32_t next_injection_time = (uint32_t)-1;
+	if (this->trace_reader != NULL && this->trace_reader->has_next()) next_injection_time = this->trace_reader->get_next_injection_cycle();
+	if (next_injection_time <= global_clock) return;
+	for (uint32_t i=0; i < this->network->num_processors; i++) {
+		uint32_t processor_injection_time = this->network->processor_lst[i]->get_next_injection_time();
+		if (processor_injection_time < next_injection_time) next_injection_time = processor_injection_time;
+		// some processor still has flits to inject this cycle
+		if (next_injection_time <= global_clock) return;
 	}
+	if (next_injection_time == (uint32_t)-1) return;
+
+	// every skipped cycle has nothing transmitted, received, stalled or buffered, so log them as a single run
+	// after closing off the cycles simulated since the last sample
+	uint32_t num_idle_cycles = next_injection_time - global_clock;
+	if (this->num_cycles_since_sample > 0) this->sample_over_time_metrics();
+	this->over_time_recorder->add_idle_cycles(num_idle_cycles, this->last_sample_metrics.buffers_space_total);
 
-	this->tx_flits_over_time_vec->push_back(sum_tx_flits);
-	this->rx_flits_over_time_vec->push_back(sum_rx_flits);
-	this->stalls_over_time_vec->push_back(sum_num_stalls);
-	float buffers_efficiency = (float)sum_buffers_space_occupied / (float)sum_buffers_space_total;
-	this->buffers_efficiency_over_time_vec->push_back(buffers_efficiency);
+	if (this->is_verbose) printf("Fast Forwarding %d Idle Clock Cycles\n", num_idle_cycles);
+	global_clock = next_injection_time;
 }
 
+// copy every trace record that is due by now into its source processor's queue
+void Simulator::release_trace_messages () {
+	if (this->trace_reader == NULL) return;
+	while (this->trace_reader->has_next() && this->trace_reader->get_next_injection_cycle() <= global_clock) {
+		uint32_t message_id = this->trace_reader->get_next_id();
+		Trace_Record record = *this->trace_reader->next();
+		assert(record.source != record.dest);
+		assert(record.dependency_id == NO_DEPENDENCY || record.dependency_id < message_id);
+		Message message(record.size, message_id, record.source, record.dest, record.injection_cycle, record.dependency_id);
+		global_message_transmission_info[message_id].creation_time = (int)record.injection_cycle;
+		global_completion_tracker->record_created(&global_message_transmission_info[message_id]);
+		this->network->processor_lst[record.source]->enqueue_message(message);
+	}
+}
+
+// averages are over the delivered messages, which is all of them unless the run deadlocked
 void Simulator::update_aggregate_metrics () {
-	uint32_t num_messages = this->message_generator->num_messages;
+	uint32_t num_messages = this->num_messages;
+	uint32_t num_measured_messages = 0;
 
 	#pragma omp parallel 
 	{
+		uint32_t thread_num_messages = 0;
 		uint32_t thread_message_latency = 0;
-		float thread_message_distance = 0;
+		uint32_t thread_message_queueing_delay = 0;
 		uint32_t thread_message_size = 0;
 
 		#pragma omp for schedule(static) nowait
 		for (uint32_t i=0; i < num_messages; i++) {
-			Message_Transmission_Info* message_transmission_info = global_message_transmission_info[i];
+			Message_Transmission_Info* message_transmission_info = &global_message_transmission_info[i];
+			if (!this->is_measured_message(message_transmission_info)) continue;
+			thread_num_messages++;
 			thread_message_latency += message_transmission_info->latency;
-			thread_message_distance += message_transmission_info->avg_packet_distance;
+			thread_message_queueing_delay += message_transmission_info->tx_time - message_transmission_info->creation_time;
 			thread_message_size += message_transmission_info->size;
 		}
 
+		#pragma omp atomic
+		num_measured_messages += thread_num_messages;
 		#pragma omp atomic
 		this->total_message_latency += thread_message_latency;
 		#pragma omp atomic
-		this->total_message_distance += thread_message_distance;
+		this->total_message_queueing_delay += thread_message_queueing_delay;
 		#pragma omp atomic
 		this->total_message_size += thread_message_size;
 	}
 
-	this->avg_message_latency = (float)this->total_message_latency / (float)num_messages;
-	this->avg_message_distance = this->total_message_distance / (float)num_messages;
-	this->avg_message_size = this->total_message_size / (float)num_messages;
-	this->avg_message_throughput = (float)num_messages / (float)global_clock;
+	// float sum is accumulated serially so it does not depend on the thread count
+	for (uint32_t i=0; i < num_messages; i++) {
+		if (!this->is_measured_message(&global_message_transmission_info[i])) continue;
+		this->total_message_distance += global_message_transmission_info[i].avg_packet_distance;
+	}
+
+	// with a measurement window, throughput is the tagged messages over the cycles they were created in
+	uint32_t num_measured_cycles = this->measurement_cycles > 0 ? this->measurement_cycles : global_clock;
+	this->num_measured_messages = num_measured_messages;
+	this->avg_message_latency = (float)this->total_message_latency / (float)num_measured_messages;
+	this->avg_message_queueing_delay = (float)this->total_message_queueing_delay / (float)num_measured_messages;
+	this->avg_message_distance = this->total_message_distance / (float)num_measured_messages;
+	this->avg_message_size = this->total_message_size / (float)num_measured_messages;
+	this->avg_message_throughput = (float)num_measured_messages / (float)num_measured_cycles;
 	this->avg_message_speed = this->avg_message_distance / this->avg_message_latency;
+
+	// merged in processor order, the counts do not depend on which thread received what
+	this->latency_histogram_set = new Latency_Histogram_Set(this->network->num_processors, this->num_latency_regions);
+	for (uint32_t i=0; i < this->network->num_processors; i++) {
+		this->latency_histogram_set->merge(this->network->processor_lst[i]->latency_histogram_set);
+	}
+}
+
+static void simulate_worker_pool_thread (uint32_t thread_id, void* arg) {
+	((Simulator*)arg)->simulate_worker_pool_cycles(thread_id);
+}
+
+// one cycle is tx, rx and summarize over this thread's partition, with the last thread to finish doing the bookkeeping
+void Simulator::simulate_worker_pool_cycles (uint32_t thread_id) {
+	Sense_Barrier* barrier = this->worker_pool->barrier;
+
+	while (!this->is_simulation_finished) {
+		this->network->tx_partition(thread_id);
+		barrier->wait(thread_id);
+		this->network->rx_partition(thread_id);
+		barrier->wait(thread_id);
+		this->network->summarize_partition(thread_id);
+		if (this->is_sample_due) this->network->sum_partition_metrics(thread_id, &this->thread_over_time_metrics[thread_id]);
+		if (barrier->arrive(thread_id)) {
+			global_clock++;
+			this->is_thread_metrics_fresh = this->is_sample_due;
+			this->update_over_time_metrics();
+			this->update_heatmap();
+			this->update_simulation_status();
+			if (!this->is_simulation_finished) this->fast_forward_quiescent_cycles();
+			this->release_trace_messages();
+			if (!this->is_simulation_finished) this->update_checkpoint();
+			this->is_sample_due = (this->num_cycles_since_sample + 1 >= this->sample_interval);
+			barrier->release(thread_id);
+		}
+	}
 }
 
 void Simulator::simulate () {
 	printf("Staring Simulation...\n\n");
 
+	if (this->engine == WORKER_POOL) {
+		this->is_sample_due = (this->num_cycles_since_sample + 1 >= this->sample_interval);
+		this->worker_pool->run(&simulate_worker_pool_thread, (void*)this);
+	}
+
 	while (!this->is_simulation_finished) {
 		// printf("Starting Global Clock Cycle %d\n", global_clock);
 		this->network->simulate();
@@ -329,13 +838,31 @@ void Simulator::simulate () {
 		// printf("Finished Global Clock Cycle %d\n\n", global_clock);
 		global_clock++;
 		this->update_over_time_metrics();
+		this->update_heatmap();
 		this->update_simulation_status();
+		if (!this->is_simulation_finished) this->fast_forward_quiescent_cycles();
+		this->release_trace_messages();
+		if (!this->is_simulation_finished) this->update_checkpoint();
+	}
+	// the cycles since the last sample and the windows still held back go out before the per message stats
+	if (this->num_cycles_since_sample > 0) this->sample_over_time_metrics();
+	this->over_time_recorder->close();
+	if (this->heatmap_writer != NULL) {
+		if (this->last_heatmap_cycle != global_clock) this->network->write_heatmap_snapshot(this->heatmap_writer);
+		this->heatmap_writer->close();
 	}
 	printf("Finished Simulation!!!\n\n");
+	if (this->is_deadlocked) printf("Simulation Stopped Early by a Deadlock, Stats Only Cover Delivered Messages\n\n");
+	else if (!global_completion_tracker->is_batch_delivered(TAGGED_BATCH)) {
+		printf("Drain Phase Timed Out, Stats Do Not Cover %d Undelivered Tagged Messages\n\n", global_completion_tracker->get_num_outstanding(TAGGED_BATCH));
+	}
 	if (this->is_verbose) this->print_global_message_transmission_info();
 
 	this->update_aggregate_metrics();
 	this->print_aggregate_metrics();
+	if (this->measurement_cycles > 0) {
+		printf("Measured %d Messages Created in Clock Cycles %d to %d\n", this->num_measured_messages, this->warmup_cycles, this->measurement_end);
+	}
 	printf("Total Simulation Time in Clock Cycles: %d\n\n", global_clock);
 
 	printf("Starting Logging Stats...\n\n");
@@ -344,45 +871,11 @@ void Simulator::simulate () {
 
 }
 
+// per message and aggregate stats go after the over time stats, then the file is closed
 void Simulator::log_stats () {
-	std::ofstream tx_stats_file(this->tx_stats_path);
-	for (auto itr=this->tx_flits_over_time_vec->begin(); itr != this->tx_flits_over_time_vec->end(); itr++) {
-		uint32_t val = *itr;
-		tx_stats_file << val << std::endl;
-	}
-	tx_stats_file.close();
-
-	std::ofstream rx_stats_file(this->rx_stats_path);
-	for (auto itr=this->rx_flits_over_time_vec->begin(); itr != this->rx_flits_over_time_vec->end(); itr++) {
-		uint32_t val = *itr;
-		rx_stats_file << val << std::endl;
-	}
-	rx_stats_file.close();
-
-	std::ofstream stalls_stats_file(this->stalls_stats_path);
-	for (auto itr=this->stalls_over_time_vec->begin(); itr != this->stalls_over_time_vec->end(); itr++) {
-		uint32_t val = *itr;
-		stalls_stats_file << val << std::endl;
-	}
-	stalls_stats_file.close();
-
-	std::ofstream buffers_stats_file(this->buffers_stats_path);
-	for (auto itr=this->buffers_efficiency_over_time_vec->begin(); itr != this->buffers_efficiency_over_time_vec->end(); itr++) {
-		float val = *itr;
-		buffers_stats_file << val << std::endl;
-	}
-	buffers_stats_file.close();
-
-	std::ofstream transmissions_stats_file(this->transmissions_stats_path);
-	transmissions_stats_file << "Latency" << " " \
-							 << "Size" << " " \
-							 << "Distance" << " " \
-							 << "TX_Processor_ID" << " " \
-							 << "TX_Time" << " " \
-							 << "RX_Processor_ID" << " " \
-							 << "RX_Time" << std::endl;
-	for (uint32_t i=0; i < this->message_generator->num_messages; i++) {
-		Message_Transmission_Info* message_transmission_info = global_message_transmission_info[i];
+	for (uint32_t i=0; i < this->num_messages; i++) {
+		Message_Transmission_Info* message_transmission_info = &global_message_transmission_info[i];
+		if (!this->is_measured_message(message_transmission_info)) continue;
 
 		uint32_t latency = message_transmission_info->latency;
 		uint32_t size = message_transmission_info->size;
@@ -392,51 +885,90 @@ void Simulator::log_stats () {
 		uint32_t rx_processor_id = message_transmission_info->rx_processor_id;
 		uint32_t rx_time = message_transmission_info->rx_time;
 
-		transmissions_stats_file << latency << " " \
-								 << size << " " \
-								 << distance << " " \
-								 << tx_processor_id << " " \
-								 << tx_time << " " \
-								 << rx_processor_id << " " \
-								 << rx_time << std::endl;
-	}
-	transmissions_stats_file.close();
-
-	std::ofstream aggregate_stats_file(this->aggregate_stats_path);
-	aggregate_stats_file << "Average_Message_Latency_In_Clock_Cycles" << " " \
-						 << "Average_Message_Distance_In_Channels" << " " \
-						 << "Average_Message_Size" << " " \
-						 << "Average_Message_Throughput_In_Messages/Clock_Cycles" << " " \
-						 << "Average_Message_Speed_In_Distance/Latency" << std::endl;
-	aggregate_stats_file << this->avg_message_latency << " " \
-						 << this->avg_message_distance << " " \
-						 << this->avg_message_size << " " \
-						 << this->avg_message_throughput << " " \
-						 << this->avg_message_speed << std::endl;
-	aggregate_stats_file.close();
+		this->stats_writer->append_message_row(latency, size, distance, tx_processor_id, tx_time, rx_processor_id, rx_time);
+	}
+
+	this->stats_writer->append_aggregate_row(this->avg_message_latency,
+											 this->avg_message_distance,
+											 this->avg_message_size,
+											 this->avg_message_throughput,
+											 this->avg_message_speed);
+
+	// percentiles for every class that received messages, and its non empty buckets
+	for (uint32_t i=0; i < this->latency_histogram_set->get_num_classes(); i++) {
+		Latency_Histogram* histogram = this->latency_histogram_set->get_histogram(i);
+		if (histogram == NULL) continue;
+		uint32_t class_kind = this->latency_histogram_set->get_class_kind(i);
+		uint32_t class_low, class_high;
+		this->latency_histogram_set->get_class_range(i, &class_low, &class_high);
+		this->stats_writer->append_latency_percentiles_row(class_kind, class_low, class_high,
+														   histogram->get_total_count(),
+														   histogram->get_percentile(50.0),
+														   histogram->get_percentile(90.0),
+														   histogram->get_percentile(99.0),
+														   histogram->get_percentile(99.9),
+														   histogram->get_max_latency());
+		for (uint32_t j=0; j < histogram->get_num_buckets(); j++) {
+			if (histogram->get_bucket_count(j) == 0) continue;
+			this->stats_writer->append_latency_histogram_row(class_kind, class_low, class_high,
+															 Latency_Histogram::get_bucket_low(j),
+															 Latency_Histogram::get_bucket_high(j),
+															 histogram->get_bucket_count(j));
+		}
+	}
+	this->stats_writer->close(this->first_cycle, global_clock);
 }
 
 void Simulator::print_global_message_transmission_info () {
 	printf("Global Clock Cycle %d\n", global_clock);
 	printf("\n");
 	printf("%-15s%-12s%-10s%-25s%-20s%-12s%-20s%-12s\n", "Message ID", "Latency", "Size", "Avg Packet Distance", "TX Processor ID", "TX Time", "RX Processor ID", "RX Time");
-	for (uint32_t i=0; i < this->message_generator->num_messages; i++) {
-		uint32_t latency = global_message_transmission_info[i]->latency;
-		uint32_t size = global_message_transmission_info[i]->size;
-		float avg_packet_distance = global_message_transmission_info[i]->avg_packet_distance;
-		uint32_t tx_processor_id = global_message_transmission_info[i]->tx_processor_id;
-		int tx_time = global_message_transmission_info[i]->tx_time;
-		uint32_t rx_processor_id = global_message_transmission_info[i]->rx_processor_id;
-		int rx_time = global_message_transmission_info[i]->rx_time;
+	for (uint32_t i=0; i < this->num_messages; i++) {
+		uint32_t latency = global_message_transmission_info[i].latency;
+		uint32_t size = global_message_transmission_info[i].size;
+		float avg_packet_distance = global_message_transmission_info[i].avg_packet_distance;
+		uint32_t tx_processor_id = global_message_transmission_info[i].tx_processor_id;
+		int tx_time = global_message_transmission_info[i].tx_time;
+		uint32_t rx_processor_id = global_message_transmission_info[i].rx_processor_id;
+		int rx_time = global_message_transmission_info[i].rx_time;
 		printf("%-15d%-12d%-10d%-25d%-20d%-12d%-20d%-12d\n", i, latency, size, (uint32_t)avg_packet_distance, tx_processor_id, tx_time, rx_processor_id, rx_time);
 	}
 	printf("\n\n");
 }
 
+// aggregate metrics and the global latency percentiles of a finished run
+void Simulator::get_sweep_result (Sweep_Result* result) {
+	result->num_cycles = global_clock;
+	result->num_measured_messages = this->num_measured_messages;
+	result->avg_message_latency = this->avg_message_latency;
+	result->avg_message_queueing_delay = this->avg_message_queueing_delay;
+	result->avg_message_distance = this->avg_message_distance;
+	result->avg_message_size = this->avg_message_size;
+	result->avg_message_throughput = this->avg_message_throughput;
+	result->avg_message_speed = this->avg_message_speed;
+	Latency_Histogram* histogram = this->latency_histogram_set->get_histogram(0);
+	if (histogram == NULL) return;
+	result->p50_latency = histogram->get_percentile(50.0);
+	result->p90_latency = histogram->get_percentile(90.0);
+	result->p99_latency = histogram->get_percentile(99.0);
+	result->p999_latency = histogram->get_percentile(99.9);
+	result->max_latency = histogram->get_max_latency();
+}
+
 void Simulator::print_aggregate_metrics() {
 	printf("Average Message Latency in Clock Cycles: %f\n", this->avg_message_latency);
+	printf("Average Source Queueing Delay in Clock Cycles: %f\n", this->avg_message_queueing_delay);
 	printf("Average Message Distance in Channels: %f\n", this->avg_message_distance);
 	printf("Average Message Size: %f\n", this->avg_message_size);
 	printf("Average Throughput in Messages/Clock Cycles: %f\n", this->avg_message_throughput);
 	printf("Average Speed in Distance/Latency: %f\n", this->avg_message_speed);
+	Latency_Histogram* histogram = this->latency_histogram_set->get_histogram(0);
+	if (histogram != NULL) {
+		printf("Message Latency Percentiles in Clock Cycles: p50 %d p90 %d p99 %d p99.9 %d max %d\n",
+			   histogram->get_percentile(50.0),
+			   histogram->get_percentile(90.0),
+			   histogram->get_percentile(99.0),
+			   histogram->get_percentile(99.9),
+			   histogram->get_max_latency());
+	}
 }
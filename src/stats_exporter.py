@@ -0,0 +1,213 @@
+import struct
+import sys
+import os
+
+# usage: python3 src/stats_exporter.py <test path> [--csv | --sweep]
+# reads the stats.bin written by the simulator and writes the text stats files the notebooks and
+# data_visualizer.py read, or one csv file per table with --csv, plus heatmap.csv from heatmap.bin.
+# with --sweep the test path is a sweep output directory and sweep_results.bin becomes sweep_results.csv
+
+stats_magic = 0x5354534e
+header_format = "<IIQIIII"
+
+heatmap_magic = 0x504d484e
+heatmap_header_format = "<IIIIIIII"
+heatmap_port_names = ["north", "east", "south", "west", "injection", "ejection"]
+
+sweep_magic = 0x5057534e
+sweep_header_format = "<IIIIQQ"
+sweep_result_format = "<IIiIIIIffffffIIIIId"
+sweep_result_columns = ["run_id", "status", "exit_code", "config_offset", "config_size", "num_cycles", "num_measured_messages",
+						"avg_message_latency", "avg_message_queueing_delay", "avg_message_distance", "avg_message_size",
+						"avg_message_throughput", "avg_message_speed", "p50_latency", "p90_latency", "p99_latency",
+						"p999_latency", "max_latency", "simulation_time"]
+sweep_status_names = ["pending", "finished", "deadlocked", "failed"]
+
+def read_stats(stats_path):
+	with open(stats_path, "rb") as stats_file:
+		data = stats_file.read()
+
+	magic, version, config_hash, first_cycle, last_cycle, schema_size, _ = struct.unpack_from(header_format, data, 0)
+	if magic != stats_magic:
+		sys.exit(stats_path + " is not a stats file")
+	offset = struct.calcsize(header_format)
+
+	# one line per table, "table column:type column:type ..."
+	table_lst = []
+	for line in data[offset:offset+schema_size].decode('utf-8').strip().split("\n"):
+		items = line.split()
+		columns = [(item.split(":")[0], item.split(":")[1]) for item in items[1:]]
+		table_lst.append({"name": items[0], "columns": columns, "data": {column[0]: [] for column in columns}})
+	offset += schema_size
+
+	while offset < len(data):
+		table_id, num_rows = struct.unpack_from("<II", data, offset)
+		offset += 8
+		table = table_lst[table_id]
+		for name, column_type in table["columns"]:
+			value_format = "<" + str(num_rows) + ("f" if column_type == "f32" else "I")
+			table["data"][name].extend(struct.unpack_from(value_format, data, offset))
+			offset += 4 * num_rows
+
+	info = {"version": version, "config_hash": config_hash, "first_cycle": first_cycle, "last_cycle": last_cycle}
+	return info, {table["name"]: table for table in table_lst}
+
+# matches how the simulator used to print a float through an ostream
+def format_float(val):
+	return "%g" % val
+
+# rounds through a 32 bit float like the simulator's own float math
+def to_float32(val):
+	return struct.unpack("f", struct.pack("f", val))[0]
+
+# the text files have one line per cycle, so every cycle of a window gets the window's per cycle mean
+def format_count_per_cycle(count_sum, num_cycles):
+	if count_sum % num_cycles == 0:
+		return str(count_sum // num_cycles)
+	return format_float(count_sum / num_cycles)
+
+def format_efficiency(occupied_sum, num_samples, total):
+	if num_samples == 0:
+		return format_float(0.0)
+	return format_float(to_float32(occupied_sum / num_samples / total))
+
+def write_over_time(file_path, over_time, format_window):
+	with open(file_path, "w") as stats_file:
+		for i, num_cycles in enumerate(over_time["num_cycles"]):
+			line = format_window(over_time, i) + "\n"
+			for j in range(num_cycles):
+				stats_file.write(line)
+
+def export_text_stats(test_path):
+	info, tables = read_stats(os.path.join(test_path, "stats.bin"))
+
+	over_time = tables["over_time"]["data"]
+	write_over_time(os.path.join(test_path, "tx_stats.txt"), over_time, lambda w, i: format_count_per_cycle(w["tx_flits_sum"][i], w["num_cycles"][i]))
+	write_over_time(os.path.join(test_path, "rx_stats.txt"), over_time, lambda w, i: format_count_per_cycle(w["rx_flits_sum"][i], w["num_cycles"][i]))
+	write_over_time(os.path.join(test_path, "stalls_stats.txt"), over_time, lambda w, i: format_count_per_cycle(w["stalls_sum"][i], w["num_cycles"][i]))
+	write_over_time(os.path.join(test_path, "buffers_stats.txt"), over_time, lambda w, i: format_efficiency(w["buffers_occupied_sum"][i], w["num_samples"][i], w["buffers_total"][i]))
+
+	messages = tables["messages"]["data"]
+	with open(os.path.join(test_path, "transmissions_stats.txt"), "w") as stats_file:
+		stats_file.write("Latency Size Distance TX_Processor_ID TX_Time RX_Processor_ID RX_Time\n")
+		columns = ["latency", "size", "distance", "tx_processor_id", "tx_time", "rx_processor_id", "rx_time"]
+		for row in zip(*[messages[column] for column in columns]):
+			stats_file.write(" ".join(str(val) for val in row) + "\n")
+
+	aggregate = tables["aggregate"]["data"]
+	with open(os.path.join(test_path, "aggregate_stats.txt"), "w") as stats_file:
+		stats_file.write("Average_Message_Latency_In_Clock_Cycles Average_Message_Distance_In_Channels Average_Message_Size Average_Message_Throughput_In_Messages/Clock_Cycles Average_Message_Speed_In_Distance/Latency\n")
+		columns = ["latency", "distance", "size", "throughput", "speed"]
+		for row in zip(*[aggregate[column] for column in columns]):
+			stats_file.write(" ".join(format_float(val) for val in row) + "\n")
+
+	export_latency_stats(test_path, tables)
+
+# "global", "hops_4-7" or "region_0_to_3", see Latency_Histogram_Set::get_class_range
+def format_latency_class(class_kind, class_low, class_high):
+	if class_kind == 0:
+		return "global"
+	if class_kind == 1:
+		return "hops_" + str(class_low) + ("+" if class_high == 0xffffffff else "-" + str(class_high))
+	return "region_" + str(class_low) + "_to_" + str(class_high)
+
+def export_latency_stats(test_path, tables):
+	percentiles = tables["latency_percentiles"]["data"]
+	with open(os.path.join(test_path, "latency_stats.txt"), "w") as stats_file:
+		stats_file.write("Class Count P50 P90 P99 P99.9 Max\n")
+		columns = ["count", "p50", "p90", "p99", "p999", "max"]
+		for i in range(len(percentiles["count"])):
+			latency_class = format_latency_class(percentiles["class_kind"][i], percentiles["class_low"][i], percentiles["class_high"][i])
+			stats_file.write(latency_class + " " + " ".join(str(percentiles[column][i]) for column in columns) + "\n")
+
+def export_csv_stats(test_path):
+	info, tables = read_stats(os.path.join(test_path, "stats.bin"))
+	for name, table in tables.items():
+		columns = [column[0] for column in table["columns"]]
+		data = dict(table["data"])
+		# over time windows also get the mean of each metric over their samples
+		if name == "over_time":
+			for metric in ["tx_flits", "rx_flits", "stalls", "buffers_occupied"]:
+				columns.append(metric + "_mean")
+				data[metric + "_mean"] = [val / num_samples if num_samples > 0 else 0.0 for val, num_samples in zip(data[metric + "_sum"], data["num_samples"])]
+		with open(os.path.join(test_path, name + ".csv"), "w") as csv_file:
+			csv_file.write(",".join(columns) + "\n")
+			for row in zip(*[data[column] for column in columns]):
+				csv_file.write(",".join(str(val) for val in row) + "\n")
+
+# one row per snapshot, router and connected port, see heatmap_writer.h for the layout
+def export_heatmap_csv(test_path):
+	with open(os.path.join(test_path, "heatmap.bin"), "rb") as heatmap_file:
+		data = heatmap_file.read()
+
+	magic, version, num_rows, num_cols, num_ports, num_virtual_channels, num_snapshots, _ = struct.unpack_from(heatmap_header_format, data, 0)
+	if magic != heatmap_magic:
+		sys.exit("heatmap.bin is not a heatmap file")
+	offset = struct.calcsize(heatmap_header_format)
+	num_port_words = 4 + 4*num_virtual_channels
+
+	with open(os.path.join(test_path, "heatmap.csv"), "w") as csv_file:
+		columns = ["cycle", "row", "col", "port", "flits_carried", "busy_cycles", "blocked_cycles"]
+		for i in range(num_virtual_channels):
+			columns += ["vc" + str(i) + "_mean_occupancy", "vc" + str(i) + "_blocked_cycles"]
+		csv_file.write(",".join(columns) + "\n")
+		for snapshot in range(num_snapshots):
+			cycle, _ = struct.unpack_from("<II", data, offset)
+			offset += 8
+			for router in range(num_rows * num_cols):
+				for port in range(num_ports):
+					words = struct.unpack_from("<" + str(num_port_words) + "I", data, offset)
+					offset += 4 * num_port_words
+					if words[3] == 0:
+						continue
+					row = [cycle, router // num_cols, router % num_cols, heatmap_port_names[port], words[0], words[1], words[2]]
+					for i in range(num_virtual_channels):
+						vc_words = words[4 + 4*i : 8 + 4*i]
+						occupancy_sum = vc_words[0] | (vc_words[1] << 32)
+						row += [occupancy_sum / cycle if cycle > 0 else 0.0, vc_words[2]]
+					csv_file.write(",".join(str(val) for val in row) + "\n")
+
+# one row per run, the swept options as leading columns, see sweep_runner.h for the layout
+def export_sweep_csv(sweep_path):
+	with open(os.path.join(sweep_path, "sweep_results.bin"), "rb") as sweep_file:
+		data = sweep_file.read()
+
+	magic, version, num_runs, _, string_table_offset, string_table_size = struct.unpack_from(sweep_header_format, data, 0)
+	if magic != sweep_magic:
+		sys.exit("sweep_results.bin is not a sweep results file")
+	string_table = data[string_table_offset:string_table_offset+string_table_size].decode('utf-8')
+
+	row_lst = []
+	option_names = []
+	offset = struct.calcsize(sweep_header_format)
+	for i in range(num_runs):
+		result = dict(zip(sweep_result_columns, struct.unpack_from(sweep_result_format, data, offset)))
+		offset += struct.calcsize(sweep_result_format)
+		options = {}
+		for line in string_table[result["config_offset"]:result["config_offset"]+result["config_size"]].strip().split("\n"):
+			if line == "":
+				continue
+			name, val = line.split(": ", 1)
+			options[name] = val
+			if name not in option_names:
+				option_names.append(name)
+		row_lst.append((options, result))
+
+	columns = [column for column in sweep_result_columns if column not in ("config_offset", "config_size")]
+	with open(os.path.join(sweep_path, "sweep_results.csv"), "w") as csv_file:
+		csv_file.write(",".join(option_names + columns) + "\n")
+		for options, result in row_lst:
+			result["status"] = sweep_status_names[result["status"]]
+			row = [options.get(name, "") for name in option_names] + [result[column] for column in columns]
+			csv_file.write(",".join(str(val) for val in row) + "\n")
+
+if __name__ == "__main__":
+	test_path = sys.argv[1]
+	if len(sys.argv) > 2 and sys.argv[2] == "--sweep":
+		export_sweep_csv(test_path)
+	elif len(sys.argv) > 2 and sys.argv[2] == "--csv":
+		export_csv_stats(test_path)
+		if os.path.exists(os.path.join(test_path, "heatmap.bin")):
+			export_heatmap_csv(test_path)
+	else:
+		export_text_stats(test_path)
@@ -0,0 +1,186 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "stats_writer.h"
+
+static const char* stats_schema =
+	"over_time num_cycles:u32 num_samples:u32 tx_flits_sum:u32 tx_flits_min:u32 tx_flits_max:u32 "
+	"rx_flits_sum:u32 rx_flits_min:u32 rx_flits_max:u32 stalls_sum:u32 stalls_min:u32 stalls_max:u32 "
+	"buffers_occupied_sum:u32 buffers_occupied_min:u32 buffers_occupied_max:u32 buffers_total:u32\n"
+	"messages latency:u32 size:u32 distance:u32 tx_processor_id:u32 tx_time:u32 rx_processor_id:u32 rx_time:u32\n"
+	"aggregate latency:f32 distance:f32 size:f32 throughput:f32 speed:f32\n"
+	"latency_percentiles class_kind:u32 class_low:u32 class_high:u32 count:u32 p50:u32 p90:u32 p99:u32 p999:u32 max:u32\n"
+	"latency_histogram class_kind:u32 class_low:u32 class_high:u32 bucket_low:u32 bucket_high:u32 count:u32\n";
+
+static const uint32_t num_table_columns[NUM_STATS_TABLES] = {15, 7, 5, 9, 6};
+
+static uint64_t hash_file (std::string file_path) {
+	uint64_t hash = 14695981039346656037ULL;
+	FILE* file = fopen(file_path.c_str(), "rb");
+	if (file == NULL) return 0;
+	int c;
+	while ((c = fgetc(file)) != EOF) {
+		hash ^= (uint8_t)c;
+		hash *= 1099511628211ULL;
+	}
+	fclose(file);
+	return hash;
+}
+
+static uint32_t float_bits (float val) {
+	uint32_t bits;
+	memcpy(&bits, &val, sizeof(float));
+	return bits;
+}
+
+Stats_Writer::Stats_Writer (std::string stats_file_path, std::string config_file_path) {
+	this->stats_file = fopen(stats_file_path.c_str(), "wb");
+	assert(this->stats_file != NULL);
+
+	// cycle range is filled in on close
+	this->header.magic = STATS_MAGIC;
+	this->header.version = STATS_VERSION;
+	this->header.config_hash = hash_file(config_file_path);
+	this->header.first_cycle = 0;
+	this->header.last_cycle = 0;
+	this->header.schema_size = strlen(stats_schema);
+	this->header.reserved = 0;
+	fwrite(&this->header, sizeof(Stats_Header), 1, this->stats_file);
+	fwrite(stats_schema, 1, this->header.schema_size, this->stats_file);
+
+	this->full_chunk_queue = new std::deque<Stats_Chunk*>;
+	this->free_chunk_vec = new std::vector<Stats_Chunk*>;
+	for (uint32_t i=0; i < NUM_STATS_TABLES; i++) this->open_chunk_lst[i] = this->get_free_chunk(i);
+	this->is_closed = false;
+	this->writer_thread = new std::thread(&Stats_Writer::write_chunks, this);
+}
+
+// only after close, once the writer thread is gone and every full chunk is back on the free list
+Stats_Writer::~Stats_Writer () {
+	assert(this->is_closed);
+	for (uint32_t i=0; i < NUM_STATS_TABLES; i++) this->free_chunk_vec->push_back(this->open_chunk_lst[i]);
+	for (uint32_t i=0; i < this->free_chunk_vec->size(); i++) {
+		delete[] (*this->free_chunk_vec)[i]->column_data;
+		delete (*this->free_chunk_vec)[i];
+	}
+	delete this->free_chunk_vec;
+	delete this->full_chunk_queue;
+	delete this->writer_thread;
+}
+
+Stats_Chunk* Stats_Writer::get_free_chunk (uint32_t table_id) {
+	Stats_Chunk* chunk = NULL;
+	{
+		std::lock_guard<std::mutex> guard(this->chunk_lock);
+		if (!this->free_chunk_vec->empty()) {
+			chunk = this->free_chunk_vec->back();
+			this->free_chunk_vec->pop_back();
+		}
+	}
+	if (chunk == NULL) {
+		chunk = new Stats_Chunk;
+		chunk->column_data = new uint32_t[STATS_MAX_COLUMNS * STATS_CHUNK_ROWS];
+	}
+	chunk->table_id = table_id;
+	chunk->num_rows = 0;
+	return chunk;
+}
+
+void Stats_Writer::submit_chunk (uint32_t table_id) {
+	Stats_Chunk* chunk = this->open_chunk_lst[table_id];
+	{
+		std::lock_guard<std::mutex> guard(this->chunk_lock);
+		this->full_chunk_queue->push_back(chunk);
+	}
+	this->chunk_cond.notify_one();
+	this->open_chunk_lst[table_id] = this->get_free_chunk(table_id);
+}
+
+void Stats_Writer::append_row (uint32_t table_id, const uint32_t* row) {
+	Stats_Chunk* chunk = this->open_chunk_lst[table_id];
+	for (uint32_t i=0; i < num_table_columns[table_id]; i++) {
+		chunk->column_data[i*STATS_CHUNK_ROWS + chunk->num_rows] = row[i];
+	}
+	chunk->num_rows++;
+	if (chunk->num_rows == STATS_CHUNK_ROWS) this->submit_chunk(table_id);
+}
+
+void Stats_Writer::append_over_time_row (Over_Time_Window* window) {
+	uint32_t row[15] = {window->num_cycles, window->num_samples,
+						window->tx_flits.sum, window->tx_flits.min, window->tx_flits.max,
+						window->rx_flits.sum, window->rx_flits.min, window->rx_flits.max,
+						window->num_stalls.sum, window->num_stalls.min, window->num_stalls.max,
+						window->buffers_space_occupied.sum, window->buffers_space_occupied.min, window->buffers_space_occupied.max,
+						window->buffers_space_total};
+	this->append_row(OVER_TIME_TABLE, row);
+}
+
+void Stats_Writer::append_message_row (uint32_t latency, uint32_t size, uint32_t distance, uint32_t tx_processor_id, uint32_t tx_time, uint32_t rx_processor_id, uint32_t rx_time) {
+	uint32_t row[7] = {latency, size, distance, tx_processor_id, tx_time, rx_processor_id, rx_time};
+	this->append_row(MESSAGES_TABLE, row);
+}
+
+void Stats_Writer::append_aggregate_row (float latency, float distance, float size, float throughput, float speed) {
+	uint32_t row[5] = {float_bits(latency), float_bits(distance), float_bits(size), float_bits(throughput), float_bits(speed)};
+	this->append_row(AGGREGATE_TABLE, row);
+}
+
+void Stats_Writer::append_latency_percentiles_row (uint32_t class_kind, uint32_t class_low, uint32_t class_high, uint32_t count, uint32_t p50, uint32_t p90, uint32_t p99, uint32_t p999, uint32_t max) {
+	uint32_t row[9] = {class_kind, class_low, class_high, count, p50, p90, p99, p999, max};
+	this->append_row(LATENCY_PERCENTILES_TABLE, row);
+}
+
+void Stats_Writer::append_latency_histogram_row (uint32_t class_kind, uint32_t class_low, uint32_t class_high, uint32_t bucket_low, uint32_t bucket_high, uint32_t count) {
+	uint32_t row[6] = {class_kind, class_low, class_high, bucket_low, bucket_high, count};
+	this->append_row(LATENCY_HISTOGRAM_TABLE, row);
+}
+
+// runs on the writer thread until close() has been called and every chunk is out
+void Stats_Writer::write_chunks () {
+	while (true) {
+		Stats_Chunk* chunk;
+		{
+			std::unique_lock<std::mutex> guard(this->chunk_lock);
+			while (this->full_chunk_queue->empty() && !this->is_closed) this->chunk_cond.wait(guard);
+			if (this->full_chunk_queue->empty()) return;
+			chunk = this->full_chunk_queue->front();
+			this->full_chunk_queue->pop_front();
+		}
+
+		fwrite(&chunk->table_id, sizeof(uint32_t), 1, this->stats_file);
+		fwrite(&chunk->num_rows, sizeof(uint32_t), 1, this->stats_file);
+		for (uint32_t i=0; i < num_table_columns[chunk->table_id]; i++) {
+			fwrite(&chunk->column_data[i*STATS_CHUNK_ROWS], sizeof(uint32_t), chunk->num_rows, this->stats_file);
+		}
+
+		std::lock_guard<std::mutex> guard(this->chunk_lock);
+		this->free_chunk_vec->push_back(chunk);
+	}
+}
+
+// flushes the partial chunks, waits for the writer thread and fills in the cycle range
+void Stats_Writer::close (uint32_t first_cycle, uint32_t last_cycle) {
+	for (uint32_t i=0; i < NUM_STATS_TABLES; i++) {
+		if (this->open_chunk_lst[i]->num_rows > 0) this->submit_chunk(i);
+	}
+	{
+		std::lock_guard<std::mutex> guard(this->chunk_lock);
+		this->is_closed = true;
+	}
+	this->chunk_cond.notify_one();
+	this->writer_thread->join();
+
+	this->header.first_cycle = first_cycle;
+	this->header.last_cycle = last_cycle;
+	fseek(this->stats_file, 0, SEEK_SET);
+	fwrite(&this->header, sizeof(Stats_Header), 1, this->stats_file);
+	fclose(this->stats_file);
+}
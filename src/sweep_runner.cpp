@@ -0,0 +1,353 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <omp.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <CycleTimer.h>
+
+#include "sweep_runner.h"
+#include "simulator.h"
+#include "random_stream.h"
+
+typedef struct _Sweep_Option {
+	std::string key;
+	std::vector<std::string> value_vec;
+} Sweep_Option;
+
+typedef struct _Sweep_Group {
+	bool is_permute;
+	std::vector<Sweep_Option> option_vec;
+} Sweep_Group;
+
+static std::string trim (std::string str) {
+	size_t begin = str.find_first_not_of(" \t\r");
+	if (begin == std::string::npos) return "";
+	size_t end = str.find_last_not_of(" \t\r");
+	return str.substr(begin, end - begin + 1);
+}
+
+// the settings a group contributes to each of its runs, in group order
+static std::vector<Sweep_Config> expand_group (Sweep_Group* group) {
+	std::vector<Sweep_Config> group_config_vec(1);
+	if (group->is_permute) {
+		for (uint32_t i=0; i < group->option_vec.size(); i++) {
+			Sweep_Option* option = &group->option_vec[i];
+			std::vector<Sweep_Config> next_config_vec;
+			for (uint32_t j=0; j < group_config_vec.size(); j++) {
+				for (uint32_t k=0; k < option->value_vec.size(); k++) {
+					Sweep_Config config = group_config_vec[j];
+					config.push_back({option->key, option->value_vec[k]});
+					next_config_vec.push_back(config);
+				}
+			}
+			group_config_vec = next_config_vec;
+		}
+		return group_config_vec;
+	}
+
+	uint32_t num_values = group->option_vec.empty() ? 0 : group->option_vec[0].value_vec.size();
+	group_config_vec.assign(num_values, Sweep_Config());
+	for (uint32_t i=0; i < group->option_vec.size(); i++) {
+		Sweep_Option* option = &group->option_vec[i];
+		if (option->value_vec.size() != num_values) {
+			fprintf(stderr, "Zipped Sweep Option %s Has %d Values Instead of %d\n", option->key.c_str(), (int)option->value_vec.size(), num_values);
+			exit(1);
+		}
+		for (uint32_t j=0; j < num_values; j++) group_config_vec[j].push_back({option->key, option->value_vec[j]});
+	}
+	return group_config_vec;
+}
+
+Sweep_Runner::Sweep_Runner (std::string spec_file_path, std::string output_path, uint32_t num_jobs, uint32_t num_threads, SIMULATION_ENGINE engine, uint32_t seed, bool is_deterministic) {
+	this->output_path = output_path;
+	this->num_threads = num_threads;
+	this->engine = engine;
+	this->seed = seed;
+	this->is_deterministic = is_deterministic;
+	this->base_config = new Sweep_Config;
+	this->run_config_vec = new std::vector<Sweep_Config>;
+	this->config_offset_vec = new std::vector<uint32_t>;
+	this->batch_vec = new std::vector<std::vector<uint32_t>>;
+	this->results_fd = -1;
+
+	// by default every core we are allowed on runs something
+	this->num_jobs = num_jobs;
+	if (this->num_jobs == 0) {
+		cpu_set_t cpu_set;
+		uint32_t num_cores = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+		if (sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set) == 0) num_cores = CPU_COUNT(&cpu_set);
+		this->num_jobs = std::max(num_cores / std::max(num_threads, 1u), 1u);
+	}
+
+	this->parse_spec(spec_file_path);
+	this->plan_batches();
+}
+
+void Sweep_Runner::parse_spec (std::string spec_file_path) {
+	std::ifstream spec_file(spec_file_path);
+	if (!spec_file.is_open()) {
+		fprintf(stderr, "Could Not Open Sweep Spec %s\n", spec_file_path.c_str());
+		exit(1);
+	}
+
+	std::vector<Sweep_Group> group_vec;
+	std::string spec_line;
+	while (getline(spec_file, spec_line)) {
+		spec_line = trim(spec_line);
+		if (spec_line.empty() || spec_line[0] == '#') continue;
+		if (spec_line.compare("Permute") == 0 || spec_line.compare("Zip") == 0) {
+			Sweep_Group group;
+			group.is_permute = spec_line.compare("Permute") == 0;
+			group_vec.push_back(group);
+			continue;
+		}
+
+		size_t colon_idx = spec_line.find_first_of(":");
+		if (colon_idx == std::string::npos) {
+			fprintf(stderr, "Malformed Sweep Spec Line: %s\n", spec_line.c_str());
+			exit(1);
+		}
+		std::string key = trim(spec_line.substr(0, colon_idx));
+		std::string values = spec_line.substr(colon_idx + 1);
+		if (group_vec.empty()) {
+			this->base_config->push_back({key, trim(values)});
+			continue;
+		}
+
+		Sweep_Option option;
+		option.key = key;
+		size_t value_begin = 0;
+		while (value_begin <= values.size()) {
+			size_t value_end = values.find_first_of("|", value_begin);
+			if (value_end == std::string::npos) value_end = values.size();
+			option.value_vec.push_back(trim(values.substr(value_begin, value_end - value_begin)));
+			value_begin = value_end + 1;
+		}
+		group_vec.back().option_vec.push_back(option);
+	}
+
+	// cross the groups, the first group is the outermost loop
+	this->run_config_vec->assign(1, Sweep_Config());
+	for (uint32_t i=0; i < group_vec.size(); i++) {
+		std::vector<Sweep_Config> group_config_vec = expand_group(&group_vec[i]);
+		std::vector<Sweep_Config> next_config_vec;
+		for (uint32_t j=0; j < this->run_config_vec->size(); j++) {
+			for (uint32_t k=0; k < group_config_vec.size(); k++) {
+				Sweep_Config config = (*this->run_config_vec)[j];
+				config.insert(config.end(), group_config_vec[k].begin(), group_config_vec[k].end());
+				next_config_vec.push_back(config);
+			}
+		}
+		*this->run_config_vec = next_config_vec;
+	}
+}
+
+uint32_t Sweep_Runner::get_num_runs () {return this->run_config_vec->size();}
+
+// the base config with the run's options applied
+Sweep_Config Sweep_Runner::get_full_config (uint32_t run_id) {
+	Sweep_Config config = *this->base_config;
+	Sweep_Config* run_config = &(*this->run_config_vec)[run_id];
+	for (uint32_t i=0; i < run_config->size(); i++) {
+		bool is_overridden = false;
+		for (uint32_t j=0; j < config.size(); j++) {
+			if (config[j].first.compare((*run_config)[i].first) != 0) continue;
+			config[j].second = (*run_config)[i].second;
+			is_overridden = true;
+		}
+		if (!is_overridden) config.push_back((*run_config)[i]);
+	}
+	return config;
+}
+
+// runs with the same network parameters share a batch. batches are capped so every job still gets some
+void Sweep_Runner::plan_batches () {
+	uint32_t max_batch_size = (this->get_num_runs() + this->num_jobs - 1) / this->num_jobs;
+	std::map<std::string, uint32_t> open_batch_map;
+	for (uint32_t i=0; i < this->get_num_runs(); i++) {
+		Sweep_Config config = this->get_full_config(i);
+		std::string network_signature;
+		for (uint32_t j=0; j < config.size(); j++) {
+			if (Simulator::is_network_parameter(config[j].first)) network_signature += config[j].first + ": " + config[j].second + "\n";
+		}
+
+		auto itr = open_batch_map.find(network_signature);
+		if (itr == open_batch_map.end() || (*this->batch_vec)[itr->second].size() >= max_batch_size) {
+			open_batch_map[network_signature] = this->batch_vec->size();
+			this->batch_vec->push_back(std::vector<uint32_t>());
+		}
+		(*this->batch_vec)[open_batch_map[network_signature]].push_back(i);
+	}
+}
+
+std::string Sweep_Runner::get_run_path (uint32_t run_id) {
+	return this->output_path + "run_" + std::to_string(run_id) + "/";
+}
+
+// every run starts out pending, a run that never reports back keeps that status unless the parent marks it failed
+void Sweep_Runner::write_results_header () {
+	if (mkdir(this->output_path.c_str(), 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "Could Not Create Sweep Output Directory %s\n", this->output_path.c_str());
+		exit(1);
+	}
+	std::string results_file_path = this->output_path + "sweep_results.bin";
+	this->results_fd = open(results_file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (this->results_fd < 0) {
+		fprintf(stderr, "Could Not Open Sweep Results File %s\n", results_file_path.c_str());
+		exit(1);
+	}
+
+	std::string string_table;
+	for (uint32_t i=0; i < this->get_num_runs(); i++) {
+		this->config_offset_vec->push_back(string_table.size());
+		Sweep_Config* run_config = &(*this->run_config_vec)[i];
+		for (uint32_t j=0; j < run_config->size(); j++) string_table += (*run_config)[j].first + ": " + (*run_config)[j].second + "\n";
+	}
+	this->config_offset_vec->push_back(string_table.size());
+
+	Sweep_Header header;
+	header.magic = SWEEP_MAGIC;
+	header.version = SWEEP_VERSION;
+	header.num_runs = this->get_num_runs();
+	header.reserved = 0;
+	header.string_table_offset = sizeof(Sweep_Header) + (uint64_t)header.num_runs * sizeof(Sweep_Result);
+	header.string_table_size = string_table.size();
+	pwrite(this->results_fd, &header, sizeof(Sweep_Header), 0);
+
+	for (uint32_t i=0; i < this->get_num_runs(); i++) {
+		Sweep_Result result;
+		memset(&result, 0, sizeof(Sweep_Result));
+		result.run_id = i;
+		result.status = SWEEP_PENDING;
+		this->write_result(&result);
+	}
+	pwrite(this->results_fd, string_table.data(), string_table.size(), header.string_table_offset);
+}
+
+// slots are disjoint, so children write theirs without coordinating
+void Sweep_Runner::write_result (Sweep_Result* result) {
+	result->config_offset = (*this->config_offset_vec)[result->run_id];
+	result->config_size = (*this->config_offset_vec)[result->run_id + 1] - result->config_offset;
+	off_t offset = sizeof(Sweep_Header) + (off_t)result->run_id * sizeof(Sweep_Result);
+	ssize_t num_written = pwrite(this->results_fd, result, sizeof(Sweep_Result), offset);
+	assert(num_written == sizeof(Sweep_Result));
+}
+
+void Sweep_Runner::read_result (uint32_t run_id, Sweep_Result* result) {
+	off_t offset = sizeof(Sweep_Header) + (off_t)run_id * sizeof(Sweep_Result);
+	ssize_t num_read = pread(this->results_fd, result, sizeof(Sweep_Result), offset);
+	assert(num_read == sizeof(Sweep_Result));
+}
+
+// runs in the forked child and never returns. every run directory gets the full config, so a run can be redone on its own
+// a child in job slot slot owns the cpus from slot * num_threads on, so worker pools of concurrent jobs do not share cpus
+void Sweep_Runner::run_child (uint32_t batch_id, uint32_t slot) {
+	std::vector<uint32_t>* batch = &(*this->batch_vec)[batch_id];
+	omp_set_num_threads(this->num_threads);
+
+	Simulator* simulator = NULL;
+	for (uint32_t i=0; i < batch->size(); i++) {
+		uint32_t run_id = (*batch)[i];
+		std::string run_path = this->get_run_path(run_id);
+		mkdir(run_path.c_str(), 0755);
+
+		Sweep_Config config = this->get_full_config(run_id);
+		FILE* config_file = fopen((run_path + "config.txt").c_str(), "w");
+		if (config_file == NULL) _exit(1);
+		for (uint32_t j=0; j < config.size(); j++) fprintf(config_file, "%s: %s\n", config[j].first.c_str(), config[j].second.c_str());
+		fclose(config_file);
+
+		if (freopen((run_path + "out.log").c_str(), "w", stdout) == NULL) _exit(1);
+		dup2(fileno(stdout), STDERR_FILENO);
+
+		// every run draws the same random numbers it would as the only run of a process
+		init_random_streams(this->seed, this->is_deterministic);
+
+		double start_time = CycleTimer::currentSeconds();
+		if (simulator == NULL) simulator = new Simulator(run_path, false, this->engine, slot * this->num_threads);
+		else simulator->reset(run_path);
+		simulator->setup();
+		simulator->simulate();
+		double end_time = CycleTimer::currentSeconds();
+		printf("Total Simulation Time in Secs: %f\n", end_time-start_time);
+
+		Sweep_Result result;
+		memset(&result, 0, sizeof(Sweep_Result));
+		simulator->get_sweep_result(&result);
+		result.run_id = run_id;
+		result.status = simulator->has_deadlocked() ? SWEEP_DEADLOCKED : SWEEP_FINISHED;
+		result.exit_code = simulator->has_deadlocked() ? 2 : 0;
+		result.simulation_time = end_time - start_time;
+		this->write_result(&result);
+		fflush(stdout);
+	}
+
+	_exit(0);
+}
+
+// forks a child per batch and keeps num_jobs of them going, returns the number of runs that failed
+uint32_t Sweep_Runner::run () {
+	this->write_results_header();
+	printf("Running %d Sweep Configs in %d Batches, %d at a Time With %d Threads Each\n\n", this->get_num_runs(), (int)this->batch_vec->size(), this->num_jobs, this->num_threads);
+
+	std::map<pid_t, uint32_t> running_map;
+	std::map<pid_t, uint32_t> slot_map;
+	std::vector<bool> is_slot_used(this->num_jobs, false);
+	uint32_t next_batch_id = 0;
+	uint32_t num_finished = 0;
+	uint32_t num_failed = 0;
+	double start_time = CycleTimer::currentSeconds();
+	while (next_batch_id < this->batch_vec->size() || !running_map.empty()) {
+		while (next_batch_id < this->batch_vec->size() && running_map.size() < this->num_jobs) {
+			uint32_t slot = 0;
+			while (is_slot_used[slot]) slot++;
+			fflush(stdout);
+			pid_t pid = fork();
+			assert(pid >= 0);
+			if (pid == 0) this->run_child(next_batch_id, slot);
+			running_map[pid] = next_batch_id++;
+			slot_map[pid] = slot;
+			is_slot_used[slot] = true;
+		}
+
+		int status;
+		pid_t pid = waitpid(-1, &status, 0);
+		assert(pid > 0);
+		std::vector<uint32_t>* batch = &(*this->batch_vec)[running_map[pid]];
+		running_map.erase(pid);
+		is_slot_used[slot_map[pid]] = false;
+		slot_map.erase(pid);
+
+		// runs of a child that died before writing their result are marked from here
+		int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status);
+		for (uint32_t i=0; i < batch->size(); i++) {
+			Sweep_Result result;
+			this->read_result((*batch)[i], &result);
+			if (result.status == SWEEP_PENDING) {
+				result.status = SWEEP_FAILED;
+				result.exit_code = exit_code;
+				this->write_result(&result);
+			}
+			if (result.status == SWEEP_FAILED) num_failed++;
+			num_finished++;
+			printf("Finished Run %d (%d of %d)%s\n", result.run_id, num_finished, this->get_num_runs(),
+				   result.status == SWEEP_FINISHED ? "" : (result.status == SWEEP_DEADLOCKED ? ", Deadlocked" : ", Failed"));
+		}
+	}
+	close(this->results_fd);
+
+	double end_time = CycleTimer::currentSeconds();
+	printf("\nFinished Sweep of %d Configs in %f Secs, %d Failed\n", this->get_num_runs(), end_time-start_time, num_failed);
+	return num_failed;
+}
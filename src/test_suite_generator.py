@@ -49,6 +49,16 @@ global_test_suite_dict = {
 																						[["Routing Algorithm:", ["Mesh XY", "Mesh Adaptive"]],
 																						 ["Flow Control Granularity:", ["Packet","Flit"]]],
 																						yes_permute]
+																				],
+
+				"topology_+_routing_+_message_distribution": [
+																					[
+																						[["Network Type:"	  , ["Mesh"   , "Mesh"         , "Torus"   , "Torus"]],
+																						 ["Routing Algorithm:", ["Mesh XY", "Mesh Adaptive", "Torus XY", "Torus Adaptive"]]],
+																						no_permute],
+																					[
+																						[["Message Node Distribution:", ["Uniform", "Transpose", "Tornado", "Bit Complement"]]],
+																						yes_permute]
 																				]
 				}
 
@@ -149,6 +159,26 @@ def delete_dir(dir_path):
 			delete_dir(new_path)
 	os.rmdir(dir_path)
 
+# the same suites as sweep specs for ./main -w, base config first, then one Permute or Zip block per option group
+def create_sweep_spec(options, sweep_spec_path):
+	sweep_spec_file = open(sweep_spec_path, "w+")
+	for key, val in base_config_dict.items():
+		sweep_spec_file.write(key + " " + str(val) + "\n")
+	for opt_group in options:
+		sweep_spec_file.write("\n" + ("Permute" if opt_group[1] == yes_permute else "Zip") + "\n")
+		for opt_name, opt_vals in opt_group[0]:
+			sweep_spec_file.write(opt_name + " " + " | ".join(str(opt_val) for opt_val in opt_vals) + "\n")
+	sweep_spec_file.close()
+
+def create_sweep_specs(test_suite_dict):
+	cwd = os.getcwd()
+	sweep_path = os.path.join(cwd, "sweeps")
+	if not os.path.exists(sweep_path):
+		os.mkdir(sweep_path)
+
+	for test_dir_name, options in test_suite_dict.items():
+		create_sweep_spec(options, os.path.join(sweep_path, test_dir_name + ".txt"))
+
 def create_test_suite(test_suite_dict):
 	cwd = os.getcwd()
 	test_suite_path = os.path.join(cwd, "test_suite")
@@ -165,6 +195,9 @@ def create_test_suite(test_suite_dict):
 		create_config_files(full_config_dict_lst, opt_config_dict_lsts, test_dir_path)
 
 if __name__ == "__main__":
-	create_test_suite(global_test_suite_dict)
+	if len(sys.argv) > 1 and sys.argv[1] == "--sweep":
+		create_sweep_specs(global_test_suite_dict)
+	else:
+		create_test_suite(global_test_suite_dict)
 
 
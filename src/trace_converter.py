@@ -0,0 +1,52 @@
+import struct
+import sys
+
+# usage: python3 src/trace_converter.py <text trace> <binary trace> [num processors]
+# text form is one message per line, "injection_cycle source dest size [dependency]", where dependency
+# is the 0 based index of an earlier message line. blank lines and lines starting with # are skipped.
+# lines have to be sorted by injection cycle, so the conversion streams and never holds the trace in memory.
+
+trace_magic = 0x4354524e
+trace_version = 1
+no_dependency = 0xFFFFFFFF
+header_format = "<6I"
+record_format = "<5I"
+
+if __name__ == "__main__":
+	text_trace_path = sys.argv[1]
+	binary_trace_path = sys.argv[2]
+	num_processors = int(sys.argv[3]) if len(sys.argv) > 3 else 0
+
+	num_records = 0
+	max_processor_id = 0
+	max_message_size = 0
+	last_injection_cycle = 0
+	with open(text_trace_path, "r") as text_trace_file, open(binary_trace_path, "wb") as binary_trace_file:
+		# header is filled in once every record has been seen
+		binary_trace_file.write(struct.pack(header_format, 0, 0, 0, 0, 0, 0))
+		for line_num, line in enumerate(text_trace_file):
+			items = line.split()
+			if len(items) == 0 or items[0].startswith("#"):
+				continue
+			if len(items) not in [4, 5]:
+				sys.exit("line " + str(line_num+1) + ": expected injection_cycle source dest size [dependency]")
+			injection_cycle, source, dest, size = [int(item) for item in items[:4]]
+			dependency = int(items[4]) if len(items) == 5 else no_dependency
+			if injection_cycle < last_injection_cycle:
+				sys.exit("line " + str(line_num+1) + ": messages are not sorted by injection cycle")
+			if source == dest:
+				sys.exit("line " + str(line_num+1) + ": source and dest are the same processor")
+			if dependency != no_dependency and dependency >= num_records:
+				sys.exit("line " + str(line_num+1) + ": dependency has to be an earlier message")
+
+			binary_trace_file.write(struct.pack(record_format, injection_cycle, source, dest, size, dependency))
+			num_records += 1
+			last_injection_cycle = injection_cycle
+			max_processor_id = max(max_processor_id, source, dest)
+			max_message_size = max(max_message_size, size)
+
+		num_processors = max(num_processors, max_processor_id + 1)
+		binary_trace_file.seek(0)
+		binary_trace_file.write(struct.pack(header_format, trace_magic, trace_version, num_records, num_processors, max_message_size, 0))
+
+	print("Converted " + str(num_records) + " Messages Over " + str(num_processors) + " Processors")
@@ -0,0 +1,90 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cassert>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "trace_reader.h"
+
+// drop consumed pages in chunks of this many records
+#define TRACE_RELEASE_RECORDS (1 << 20)
+
+Trace_Reader::Trace_Reader (std::string trace_file_path) {
+	this->fd = open(trace_file_path.c_str(), O_RDONLY);
+	if (this->fd < 0) {
+		fprintf(stderr, "Could Not Open Trace File %s\n", trace_file_path.c_str());
+		exit(1);
+	}
+	struct stat file_stat;
+	fstat(this->fd, &file_stat);
+	this->file_size = file_stat.st_size;
+	if (this->file_size < sizeof(Trace_Header)) {
+		fprintf(stderr, "Trace File %s Is Missing Its Header\n", trace_file_path.c_str());
+		exit(1);
+	}
+
+	this->file_data = (uint8_t*)mmap(NULL, this->file_size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+	assert(this->file_data != MAP_FAILED);
+	madvise(this->file_data, this->file_size, MADV_SEQUENTIAL);
+
+	Trace_Header* header = (Trace_Header*)this->file_data;
+	if (header->magic != TRACE_MAGIC || header->version != TRACE_VERSION) {
+		fprintf(stderr, "Trace File %s Has An Unknown Format\n", trace_file_path.c_str());
+		exit(1);
+	}
+	this->num_records = header->num_records;
+	this->num_processors = header->num_processors;
+	this->max_message_size = header->max_message_size;
+	if (this->file_size < sizeof(Trace_Header) + (size_t)this->num_records * sizeof(Trace_Record)) {
+		fprintf(stderr, "Trace File %s Is Truncated\n", trace_file_path.c_str());
+		exit(1);
+	}
+
+	this->record_lst = (Trace_Record*)(this->file_data + sizeof(Trace_Header));
+	this->next_record = 0;
+	this->next_released_record = 0;
+}
+
+Trace_Reader::~Trace_Reader () {
+	munmap(this->file_data, this->file_size);
+	close(this->fd);
+}
+
+bool Trace_Reader::has_next () {
+	return this->next_record < this->num_records;
+}
+
+uint32_t Trace_Reader::get_next_id () {
+	return this->next_record;
+}
+
+uint32_t Trace_Reader::get_next_injection_cycle () {
+	assert(this->has_next());
+	return this->record_lst[this->next_record].injection_cycle;
+}
+
+Trace_Record* Trace_Reader::next () {
+	assert(this->has_next());
+	Trace_Record* record = &this->record_lst[this->next_record++];
+	if (this->next_record - this->next_released_record >= TRACE_RELEASE_RECORDS) this->release_consumed_pages();
+	return record;
+}
+
+// records before the new cursor are never read again, their pages go at the next release
+void Trace_Reader::seek (uint32_t record_id) {
+	assert(record_id <= this->num_records);
+	this->next_record = record_id;
+}
+
+// the caller copies each record out before asking for the next one, so everything behind the cursor is dead
+void Trace_Reader::release_consumed_pages () {
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	size_t release_begin = (sizeof(Trace_Header) + (size_t)this->next_released_record * sizeof(Trace_Record)) / page_size * page_size;
+	size_t release_end = (sizeof(Trace_Header) + (size_t)(this->next_record - 1) * sizeof(Trace_Record)) / page_size * page_size;
+	if (release_end > release_begin) madvise(this->file_data + release_begin, release_end - release_begin, MADV_DONTNEED);
+	this->next_released_record = this->next_record - 1;
+}
@@ -0,0 +1,86 @@
+#include <stdint.h>
+
+#include "traffic_patterns.h"
+
+/* permutation patterns */
+
+// (row, col) -> (col, row)
+void transpose_traffic_pattern (const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info) {
+	uint32_t num_cols = info->num_cols;
+	for (uint32_t i=0; i < num_messages; i++) {
+		uint32_t row = source_lst[i] / num_cols;
+		uint32_t col = source_lst[i] % num_cols;
+		dest_lst[i] = col*num_cols + row;
+	}
+}
+
+// every bit of the source id flipped
+void bit_complement_traffic_pattern (const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info) {
+	uint32_t mask = (1u << info->num_bits) - 1;
+	uint32_t num_processors = info->num_processors;
+	for (uint32_t i=0; i < num_messages; i++) {
+		dest_lst[i] = (~source_lst[i] & mask) % num_processors;
+	}
+}
+
+// bits of the source id in reverse order
+void bit_reverse_traffic_pattern (const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info) {
+	uint32_t num_bits = info->num_bits;
+	uint32_t num_processors = info->num_processors;
+	for (uint32_t i=0; i < num_messages; i++) {
+		uint32_t source = source_lst[i];
+		uint32_t dest = 0;
+		for (uint32_t b=0; b < num_bits; b++) {
+			dest |= ((source >> b) & 1) << (num_bits - 1 - b);
+		}
+		dest_lst[i] = dest % num_processors;
+	}
+}
+
+// bits of the source id rotated left by one
+void shuffle_traffic_pattern (const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info) {
+	uint32_t num_bits = info->num_bits;
+	uint32_t mask = (1u << num_bits) - 1;
+	uint32_t num_processors = info->num_processors;
+	for (uint32_t i=0; i < num_messages; i++) {
+		uint32_t source = source_lst[i];
+		dest_lst[i] = (((source << 1) | (source >> (num_bits - 1))) & mask) % num_processors;
+	}
+}
+
+// just under half way around each dimension
+void tornado_traffic_pattern (const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info) {
+	uint32_t num_cols = info->num_cols;
+	uint32_t offset = (num_cols + 1)/2 - 1;
+	for (uint32_t i=0; i < num_messages; i++) {
+		uint32_t row = source_lst[i] / num_cols;
+		uint32_t col = source_lst[i] % num_cols;
+		dest_lst[i] = ((row + offset) % num_cols)*num_cols + (col + offset) % num_cols;
+	}
+}
+
+// next processor along the row, wrapping around at the edge
+void neighbor_traffic_pattern (const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info) {
+	uint32_t num_cols = info->num_cols;
+	for (uint32_t i=0; i < num_messages; i++) {
+		uint32_t row = source_lst[i] / num_cols;
+		uint32_t col = source_lst[i] % num_cols;
+		dest_lst[i] = row*num_cols + (col + 1) % num_cols;
+	}
+}
+
+/* random patterns */
+
+// a fraction of the messages goes to one of the hotspots, the rest to a uniformly random processor
+void hotspot_traffic_pattern (const uint32_t* source_lst, uint32_t* dest_lst, uint32_t num_messages, Traffic_Pattern_Info* info) {
+	uint32_t* draw_lst = info->draw_lst;
+	uint32_t* hotspot_lst = info->hotspot_lst;
+	uint32_t num_hotspots = info->num_hotspots;
+	uint32_t hotspot_threshold = info->hotspot_threshold;
+	uint32_t num_processors = info->num_processors;
+	for (uint32_t i=0; i < num_messages; i++) {
+		uint32_t hotspot = hotspot_lst[draw_lst[2*i+1] % num_hotspots];
+		uint32_t random_dest = draw_lst[2*i+1] % num_processors;
+		dest_lst[i] = (draw_lst[2*i] < hotspot_threshold) ? hotspot : random_dest;
+	}
+}
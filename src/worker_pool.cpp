@@ -0,0 +1,137 @@
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <pthread.h>
+#include <sched.h>
+#include <vector>
+
+#include "worker_pool.h"
+
+// spins before yielding, so oversubscribed runs still make progress
+#define NUM_SPINS_BEFORE_YIELD 1024
+
+static void pin_thread (pthread_t thread, uint32_t cpu) {
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	CPU_SET(cpu, &cpu_set);
+	pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpu_set);
+}
+
+Sense_Barrier::Sense_Barrier (uint32_t num_threads) {
+	this->num_threads = num_threads;
+	this->num_arrived.store(0);
+	this->sense.store(false);
+	this->thread_senses = new Thread_Sense[this->num_threads];
+	for (uint32_t i=0; i < this->num_threads; i++) this->thread_senses[i].sense = false;
+}
+
+// returns true on the last thread to arrive, which has to call release once its serial work is done
+bool Sense_Barrier::arrive (uint32_t thread_id) {
+	bool thread_sense = !this->thread_senses[thread_id].sense;
+	this->thread_senses[thread_id].sense = thread_sense;
+	if (this->num_arrived.fetch_add(1, std::memory_order_acq_rel) == this->num_threads - 1) {
+		this->num_arrived.store(0, std::memory_order_relaxed);
+		return true;
+	}
+	uint32_t num_spins = 0;
+	while (this->sense.load(std::memory_order_acquire) != thread_sense) {
+		if (++num_spins >= NUM_SPINS_BEFORE_YIELD) {
+			std::this_thread::yield();
+			num_spins = 0;
+		}
+	}
+	return false;
+}
+
+void Sense_Barrier::release (uint32_t thread_id) {
+	this->sense.store(this->thread_senses[thread_id].sense, std::memory_order_release);
+}
+
+void Sense_Barrier::wait (uint32_t thread_id) {
+	if (this->arrive(thread_id)) this->release(thread_id);
+}
+
+Worker_Pool::Worker_Pool (uint32_t num_threads, uint32_t first_cpu) {
+	this->num_threads = num_threads;
+	this->barrier = new Sense_Barrier(num_threads);
+	this->job_func = NULL;
+	this->job_arg = NULL;
+	this->job_id = 0;
+	this->num_running_threads = 0;
+	this->is_shutdown = false;
+
+	// only cpus we are allowed on are used, starting at first_cpu, so pools of concurrent
+	// processes can be given disjoint slices; without enough of them the threads float
+	std::vector<uint32_t> cpus;
+	this->is_pinned = false;
+	if (sched_getaffinity(0, sizeof(cpu_set_t), &this->caller_cpu_set) == 0) {
+		for (uint32_t cpu=0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &this->caller_cpu_set)) cpus.push_back(cpu);
+		}
+		this->is_pinned = (first_cpu + this->num_threads <= cpus.size());
+	}
+
+	if (this->is_pinned) pin_thread(pthread_self(), cpus[first_cpu]);
+	this->threads = new std::thread*[this->num_threads];
+	this->threads[0] = NULL;
+	for (uint32_t i=1; i < this->num_threads; i++) {
+		this->threads[i] = new std::thread(&Worker_Pool::worker_loop, this, i);
+		if (this->is_pinned) pin_thread(this->threads[i]->native_handle(), cpus[first_cpu + i]);
+	}
+}
+
+Worker_Pool::~Worker_Pool () {
+	{
+		std::unique_lock<std::mutex> guard(this->lock);
+		this->is_shutdown = true;
+	}
+	this->job_ready.notify_all();
+	for (uint32_t i=1; i < this->num_threads; i++) {
+		this->threads[i]->join();
+		delete(this->threads[i]);
+	}
+	delete[](this->threads);
+	delete(this->barrier);
+	// the caller ran as thread 0, so it gets its old cpus back
+	if (this->is_pinned) pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &this->caller_cpu_set);
+}
+
+void Worker_Pool::worker_loop (uint32_t thread_id) {
+	uint32_t last_job_id = 0;
+	while (true) {
+		Worker_Func func;
+		void* arg;
+		{
+			std::unique_lock<std::mutex> guard(this->lock);
+			while (!this->is_shutdown && this->job_id == last_job_id) this->job_ready.wait(guard);
+			if (this->is_shutdown) return;
+			last_job_id = this->job_id;
+			func = this->job_func;
+			arg = this->job_arg;
+		}
+
+		func(thread_id, arg);
+
+		std::unique_lock<std::mutex> guard(this->lock);
+		if (--this->num_running_threads == 0) this->job_done.notify_one();
+	}
+}
+
+// runs func on every thread of the pool and returns once all of them have finished
+void Worker_Pool::run (Worker_Func func, void* arg) {
+	{
+		std::unique_lock<std::mutex> guard(this->lock);
+		this->job_func = func;
+		this->job_arg = arg;
+		this->num_running_threads = this->num_threads - 1;
+		this->job_id++;
+	}
+	this->job_ready.notify_all();
+
+	func(0, arg);
+
+	std::unique_lock<std::mutex> guard(this->lock);
+	while (this->num_running_threads > 0) this->job_done.wait(guard);
+}